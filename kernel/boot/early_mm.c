@@ -19,7 +19,10 @@
  * _text_start -  _rodata_end: mapped ro, contains .text and .rodata sections
  *                             of the kernel;
  * _data_start -  _bss_end:    mapped r/w, contains .data and .bss sections
- * _bss_end    -  256MB:       mapped r/w
+ * _bss_end    -  1GB:         mapped r/w
+ *
+ * Only the first KERNEL_PGTABS * 4MB, which hold the kernel, are mapped with
+ * page tables: the rest of the first 1GB is mapped with 4MB pages (PSE).
  */
 
 #include "cpu.h"
@@ -62,6 +65,10 @@ extern char _end[];
 /* End of supported memory */
 extern char mem_end[];
 
+/* Page tables of pgtab, see crt0.S: they map the first 16MB */
+#define KERNEL_PGTABS 4
+#define LARGE_PAGE_SIZE 0x400000u
+
 /**
  * Asserts that an address is aligned on 4K.
  */
@@ -124,6 +131,9 @@ void early_mm_check(void)
 
     /* The whole kernel */
     ASSERT_CONSISTENT(_start, _end);
+
+    /* The kernel is mapped with the page tables of pgtab */
+    ASSERT_CONSISTENT(_end, KERNEL_PGTABS * LARGE_PAGE_SIZE);
 }
 
 /* Page directory */
@@ -135,8 +145,12 @@ extern unsigned pgtab[];
 #define PAGE_TABLE_RO 0x000000001u
 #define PAGE_TABLE_RW 0x000000003u
 
+/* 4MB pages */
+#define PAGE_DIR_LARGE 0x00000080u
+
 /**
- * Fill the provided pgdir with references on a big page table.
+ * Fill the provided pgdir with references on a big page table, and clear the
+ * other entries.
  * @param pgdir the page directory to fill.
  * @param pgtab the page table to reference.
  * @param count number of entry to fill.
@@ -183,16 +197,35 @@ static void early_mm_map_region(unsigned *pdir, unsigned start, unsigned end,
     }
 }
 
+/**
+ * Performs an identity mapping of the specified region with 4MB pages.
+ * @param pagedir the page directory.
+ * @param start start address of the region.
+ * @param end end address of the region.
+ * @param flags the flags to apply to the mapping.
+ *
+ * @pre start and end have to be aligned on 4MB.
+ */
+static void early_mm_map_large_region(unsigned *pdir, unsigned start,
+                                      unsigned end, unsigned flags)
+{
+    unsigned address;
+
+    for (address = start; address < end; address += LARGE_PAGE_SIZE) {
+        pdir[address >> 22] = address | PAGE_DIR_LARGE | flags;
+    }
+}
+
 /**
  * Create kernel initial memory mapping.
  */
 void early_mm_map_kernel(void)
 {
     /* Clear page tables */
-    memset(pgtab, 0, 4096 * 64);
+    memset(pgtab, 0, 4096 * KERNEL_PGTABS);
 
-    /* Fill page directory for the first 256MB of memory */
-    early_mm_fill_pgdir(pgdir, pgtab, 64);
+    /* Fill page directory for the memory of the kernel */
+    early_mm_fill_pgdir(pgdir, pgtab, KERNEL_PGTABS);
 
     /*
          * Map all section independently, even if they are following each others
@@ -221,7 +254,9 @@ void early_mm_map_kernel(void)
                         PAGE_TABLE_RW);
     early_mm_map_region(pgdir, (unsigned)_bss_start, (unsigned)_bss_end,
                         PAGE_TABLE_RW);
-    /* Zone 6: free memory is read/write */
-    early_mm_map_region(pgdir, (unsigned)_end, (unsigned)mem_end,
-                        PAGE_TABLE_RW);
+    /* Zone 6: free memory is read/write, with 4MB pages up to 1GB */
+    early_mm_map_region(pgdir, (unsigned)_end,
+                        KERNEL_PGTABS * LARGE_PAGE_SIZE, PAGE_TABLE_RW);
+    early_mm_map_large_region(pgdir, KERNEL_PGTABS * LARGE_PAGE_SIZE,
+                              (unsigned)mem_end, PAGE_TABLE_RW);
 }
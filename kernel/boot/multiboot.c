@@ -17,12 +17,58 @@
  */
 static multiboot_info_t mb_info __attribute__ ((section (".multiboot")));
 
+/*
+ * Backup kernel command line, the bootloader may have stored it in memory
+ * cleared during boot.
+ */
+#define CMDLINE_MAX 256
+static char mb_cmdline[CMDLINE_MAX] __attribute__ ((section (".multiboot")));
+
+/*
+ * Backup memory map, for the same reason.
+ */
+#define MMAP_MAX 32
+static multiboot_memory_map_t mb_mmap[MMAP_MAX] __attribute__ ((section (".multiboot")));
+static unsigned mb_mmap_count __attribute__ ((section (".multiboot")));
+
 void multiboot_save(unsigned magic, multiboot_info_t *mb)
 {
         ASSERT(magic == MULTIBOOT_BOOTLOADER_MAGIC);
 
         /* Save the multiboot structure */
         memcpy(&mb_info, mb, sizeof(mb_info));
+
+        /* Save the command line */
+        if ((mb->flags & MULTIBOOT_INFO_CMDLINE) == MULTIBOOT_INFO_CMDLINE) {
+                strncpy(mb_cmdline, (const char *)mb->cmdline, CMDLINE_MAX - 1);
+                mb_cmdline[CMDLINE_MAX - 1] = 0;
+        }
+
+        /* Save the memory map: entries start with their size, which does not
+         * count the size field itself */
+        mb_mmap_count = 0;
+        if ((mb->flags & MULTIBOOT_INFO_MEM_MAP) == MULTIBOOT_INFO_MEM_MAP) {
+                unsigned entry = mb->mmap_addr;
+
+                while (entry < mb->mmap_addr + mb->mmap_length &&
+                       mb_mmap_count < MMAP_MAX) {
+                        multiboot_memory_map_t *mmap = (multiboot_memory_map_t *)entry;
+
+                        memcpy(&mb_mmap[mb_mmap_count++], mmap, sizeof(*mmap));
+                        entry += mmap->size + sizeof(mmap->size);
+                }
+        }
+}
+
+unsigned multiboot_mmap(const multiboot_memory_map_t **entries)
+{
+        *entries = mb_mmap;
+        return mb_mmap_count;
+}
+
+const char *multiboot_cmdline(void)
+{
+        return mb_cmdline;
 }
 
 unsigned multiboot_upper_mem(void)
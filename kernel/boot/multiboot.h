@@ -224,4 +224,11 @@ void multiboot_save(unsigned, multiboot_info_t*);
 
 unsigned multiboot_upper_mem(void);
 
+/* Memory map given by the bootloader (BIOS E820 map), empty if it did not
+ * give one. Returns the number of entries. */
+unsigned multiboot_mmap(const multiboot_memory_map_t **entries);
+
+/* Kernel command line, empty if the bootloader did not give one */
+const char *multiboot_cmdline(void);
+
 #endif /* ! MULTIBOOT_HEADER */
@@ -1,9 +1,11 @@
 #include <stdint.h>
+#include <stdbool.h>
 #include "cpu.h"
 #include "interrupts.h"
 #include "isr.h"
 #include "pic.h"
 #include "task.h"
+#include "timer.h"
 
 #define PIT_QUARTZ 0x1234DD
 #define PIT_INTERRUPT_NUMBER 32
@@ -13,10 +15,34 @@
 #define PIT_CHANNEL_3 0x42
 #define PIT_CMD 0x43
 
+#define PIT_MODE_ONESHOT 0x30
+#define PIT_MODE_PERIODIC 0x34
+#define PIT_LATCH 0x00
+#define PIT_COUNT_MAX 0xFFFF
+
+// Longest one-shot: the counter wraps past 0, so leave room to read it
+// late without mistaking the wrap for a short count.
+#define ONESHOT_MAX (PIT_COUNT_MAX - PIT_COUNT_MAX / 8)
+
+// Longest idle sleep, in ticks: less than a turn of the timer wheel, that
+// timer_ticks_to_next() looks at (see timer.c)
+#define IDLE_MAX_TICKS 255
+
 uint32_t clock_frequency = 0;
 
 uint32_t total_ticks = 0;
 
+// PIT count of one tick
+static uint16_t tick_divisor = 0;
+
+// PIT count programmed in one-shot mode, 0 when the tick is periodic
+static uint16_t oneshot_count = 0;
+// PIT counts elapsed since the last tick counted in total_ticks
+static uint32_t idle_elapsed = 0;
+// PIT counts still to sleep after the current one-shot: a sleep longer than
+// the 16 bits counter is a chain of one-shots.
+static uint32_t idle_left = 0;
+
 uint8_t  seconds = 0;
 uint8_t  minutes = 0;
 uint8_t  hours   = 0;
@@ -25,10 +51,108 @@ uint32_t days    = 0;
 static void set_clock_frequency(uint32_t hz)
 {
     uint16_t divisor = PIT_QUARTZ / hz;
-    outb(0x34, PIT_CMD);
+    outb(PIT_MODE_PERIODIC, PIT_CMD);
     outb(divisor, PIT_CHANNEL_0);
     outb(divisor / 256, PIT_CHANNEL_0);
     clock_frequency = hz;
+    tick_divisor    = divisor;
+}
+
+static uint16_t read_pit_count(void)
+{
+    outb(PIT_LATCH, PIT_CMD);
+    uint16_t low  = inb(PIT_CHANNEL_0);
+    uint16_t high = inb(PIT_CHANNEL_0);
+    return low | (high << 8);
+}
+
+/**
+ * PIT counts elapsed in the current one-shot.
+ */
+static uint16_t oneshot_elapsed(void)
+{
+    // The counter keeps counting down past 0 in one-shot mode, so this is
+    // right even if the interrupt fired a while ago.
+    return oneshot_count - read_pit_count();
+}
+
+/**
+ * Program the next one-shot of the idle sleep, out of idle_left.
+ */
+static void oneshot_start(void)
+{
+    oneshot_count = idle_left > ONESHOT_MAX ? ONESHOT_MAX : idle_left;
+    idle_left -= oneshot_count;
+
+    outb(PIT_MODE_ONESHOT, PIT_CMD);
+    outb(oneshot_count, PIT_CHANNEL_0);
+    outb(oneshot_count / 256, PIT_CHANNEL_0);
+}
+
+/**
+ * Leave the one-shot mode set by clock_idle_enter(): add the ticks spent
+ * idle to total_ticks and restart the periodic tick.
+ */
+static void clock_idle_exit(void)
+{
+    idle_elapsed += oneshot_elapsed();
+    // The periodic tick restarts from now: round to the nearest tick.
+    total_ticks += (idle_elapsed + tick_divisor / 2) / tick_divisor;
+    idle_elapsed  = 0;
+    idle_left     = 0;
+    oneshot_count = 0;
+
+    set_clock_frequency(clock_frequency);
+}
+
+void clock_idle_enter(void)
+{
+#ifdef TICKLESS_IDLE
+    uint32_t ticks;
+    uint16_t remaining;
+
+    // Woken up by another interrupt: catch up before sleeping again.
+    if (oneshot_count != 0)
+        clock_idle_exit();
+
+    // The tick is needed to share the CPU with tasks of the same priority.
+    if (ready_queue_top() != NULL)
+        return;
+
+    ticks = timer_ticks_to_next(IDLE_MAX_TICKS);
+    if (ticks < 2)
+        return;
+
+    // Part of the current tick is already elapsed: fire exactly on the
+    // tick the next timer expires.
+    remaining    = read_pit_count();
+    idle_elapsed = tick_divisor - remaining;
+    idle_left    = remaining + (ticks - 1) * tick_divisor;
+    oneshot_start();
+#endif
+}
+
+/**
+ * Account for the end of a one-shot of the idle sleep, and start the next
+ * one if the sleep goes on.
+ * @return false if the sleep is over.
+ */
+static bool clock_idle_next(void)
+{
+    uint16_t elapsed = oneshot_elapsed();
+
+    // A task woken up by another interrupt needs the tick.
+    if (!is_idle(current()) || ready_queue_top() != NULL)
+        return false;
+
+    // The interrupt may be late: the next one-shot is that much shorter.
+    if (elapsed >= oneshot_count + idle_left || idle_left == 0)
+        return false;
+
+    idle_left -= elapsed - oneshot_count;
+    idle_elapsed += elapsed;
+    oneshot_start();
+    return true;
 }
 
 void clock_handler(void)
@@ -37,9 +161,17 @@ void clock_handler(void)
 
     // Increment time
     // Display time
-    total_ticks++;
+    if (oneshot_count != 0) {
+        // In the middle of an idle sleep, there is nothing to do.
+        if (clock_idle_next())
+            return;
+        clock_idle_exit();
+    } else {
+        total_ticks++;
+    }
+    run_timers(total_ticks);
 
-    schedule();
+    schedule_tick();
 }
 
 void init_clock(void)
@@ -20,4 +20,14 @@ void clock_settings(unsigned long *quartz, unsigned long *ticks);
 
 uint32_t current_clock(void);
 
+/**
+ * Called when the CPU is about to idle. If no task is ready, program the
+ * clock in one-shot mode for the next timer expiry instead of waking up on
+ * every tick: a chain of one-shots, as the PIT counter only spans about 3
+ * ticks. The periodic tick resumes when the sleep ends or another interrupt
+ * wakes the CPU up, and total_ticks is caught up.
+ * Does nothing if TICKLESS_IDLE is not defined in parameters.h.
+ */
+void clock_idle_enter(void);
+
 #endif //__CLOCK_H__
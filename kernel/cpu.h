@@ -53,6 +53,44 @@ __inline__ static void hlt(void)
     __asm__ __volatile__ ("hlt":::"memory");
 }
 
+/*
+ * Drop the TLB entry of the page holding addr.
+ */
+__inline__ static void invlpg(unsigned long addr)
+{
+	__asm__ __volatile__("invlpg (%0)" :: "r" (addr) : "memory");
+}
+
+/*
+ * Cycles elapsed since the processor was reset.
+ */
+__inline__ static unsigned long long rdtsc(void)
+{
+	unsigned long long tsc;
+	__asm__ __volatile__("rdtsc" : "=A" (tsc));
+	return tsc;
+}
+
+/*
+ * Index of the most significant bit set in value. Undefined if value is 0.
+ */
+__inline__ static int bsr(unsigned long value)
+{
+	int index;
+	__asm__("bsrl %1,%0" : "=r" (index) : "rm" (value));
+	return index;
+}
+
+/*
+ * Index of the least significant bit set in value. Undefined if value is 0.
+ */
+__inline__ static int bsf(unsigned long value)
+{
+	int index;
+	__asm__("bsfl %1,%0" : "=r" (index) : "rm" (value));
+	return index;
+}
+
 __inline__ static unsigned long save_flags(void)
 {
 	unsigned long flags;
@@ -0,0 +1,90 @@
+/**
+ * Per-task CPU time accounting.
+ *
+ * The running task is charged the cycles (rdtsc) elapsed since its last
+ * user/kernel transition: as user time when it enters the kernel from user
+ * mode, as kernel time when it goes back to user mode or when schedule()
+ * switches it out. Time spent in the ready queue is accounted as wait time
+ * when the task starts running.
+ *
+ * Interrupts taken in kernel mode (the idle task halts in the kernel) are
+ * part of the kernel time of the current task.
+ */
+
+#include "cputime.h"
+#include "task.h"
+#include "cpu.h"
+#include "errno.h"
+#include "paging.h"
+
+static bool from_user_mode(uint32_t cs)
+{
+    return (cs & 3) == 3;
+}
+
+void cputime_enter_kernel(uint32_t cs)
+{
+    struct task *self = current();
+    uint64_t     now  = rdtsc();
+
+    if (!self || !from_user_mode(cs))
+        return;
+
+    self->cputime.user += now - self->cputime_stamp;
+    self->cputime_stamp = now;
+}
+
+void cputime_exit_kernel(uint32_t cs)
+{
+    struct task *self = current();
+    uint64_t     now  = rdtsc();
+
+    if (!self || !from_user_mode(cs))
+        return;
+
+    self->cputime.kernel += now - self->cputime_stamp;
+    self->cputime_stamp = now;
+}
+
+void cputime_switch(struct task *old_task, struct task *new_task,
+                    bool preempted)
+{
+    uint64_t now = rdtsc();
+
+    old_task->cputime.kernel += now - old_task->cputime_stamp;
+    if (preempted)
+        old_task->cputime.involuntary++;
+    else
+        old_task->cputime.voluntary++;
+
+    new_task->cputime_stamp = now;
+}
+
+uint64_t cputime_start_running(struct task *task_ptr)
+{
+    uint64_t wait = rdtsc() - task_ptr->ready_stamp;
+
+    task_ptr->cputime.wait += wait;
+    return wait;
+}
+
+int getcputime(int pid, struct task_cputime *cputime)
+{
+    struct task *task_ptr;
+    uint32_t    *dir = (uint32_t *)current()->regs[CR3];
+
+    // Both ends of the structure must be writable by the caller.
+    if (!is_user_addr(dir, (uint32_t)cputime) ||
+        !is_user_addr(dir, (uint32_t)(cputime + 1) - 1))
+        return -EINVAL;
+
+    task_ptr = pid_to_task(pid);
+    if (!task_ptr)
+        return -ESRCH;
+
+    *cputime = task_ptr->cputime;
+    // Include the time of the current slice of the caller.
+    if (is_current(task_ptr))
+        cputime->kernel += rdtsc() - task_ptr->cputime_stamp;
+    return 0;
+}
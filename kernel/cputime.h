@@ -0,0 +1,41 @@
+#ifndef __CPUTIME_H__
+#define __CPUTIME_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct task;
+struct task_cputime;
+
+/**
+ * Called by the interrupt and syscall handlers when entering the kernel.
+ * @param cs Code segment of the interrupted code: user time is accounted
+ * to the current task if it comes from user mode.
+ */
+void cputime_enter_kernel(uint32_t cs);
+
+/**
+ * Called by the interrupt and syscall handlers when leaving the kernel, with
+ * the code segment they return to.
+ */
+void cputime_exit_kernel(uint32_t cs);
+
+/**
+ * Account the kernel time of old_task up to a switch to new_task, and the
+ * context switch itself.
+ * @param preempted Whether old_task was still running, and could have kept
+ * the CPU.
+ */
+void cputime_switch(struct task *old_task, struct task *new_task,
+                    bool preempted);
+
+/**
+ * Account the time a task waited in the ready queue, when it starts running.
+ * @return the time waited, in cycles
+ */
+uint64_t cputime_start_running(struct task *task_ptr);
+
+/* see primitive.h for doc */
+int getcputime(int pid, struct task_cputime *cputime);
+
+#endif //__CPUTIME_H__
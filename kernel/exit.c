@@ -3,7 +3,6 @@
 #include "pid_allocator.h"
 #include "paging.h"
 #include "page_allocator.h"
-#include "clock.h"
 #include "msg.h"
 
 static void unlock_interrupted_child_parent(struct task *parent)
@@ -12,6 +11,25 @@ static void unlock_interrupted_child_parent(struct task *parent)
         set_task_ready(parent);
 }
 
+/**
+ * Give the children of a dying task to idle, which never waits for them:
+ * dead ones can be reaped right away, the others as soon as they die.
+ */
+static void orphan_children(struct task *task_ptr)
+{
+    struct task *child;
+    struct task *tmp;
+
+    queue_for_each_safe(child, tmp, &task_ptr->children, struct task, siblings)
+    {
+        queue_del(child, siblings);
+        child->parent = idle();
+        queue_add_tail(child, &idle()->children, siblings);
+        if (is_task_zombie(child))
+            set_zombie_orphan(child);
+    }
+}
+
 int __exit_task(struct task *task_ptr, int retval)
 {
     if (!task_ptr)
@@ -23,28 +41,16 @@ int __exit_task(struct task *task_ptr, int retval)
     if (is_task_zombie(task_ptr))
         return -ESRCH;
 
-    // Now that the task is zombie, use the task->priority field
-    // to indicate when the task died, to be compatible with set_task_zombie
-    // which always expect the sorting field to be 'priority'.
-    // When we will wake up tasks with waitpid, they will stay in the same order.
-
-    // Why UINT32_MAX? In the queue, things are ordered from highest to lowest
-    // and we want the opposite order, lowest (earliest died process) should be
-    // first.
-
-    // Why? Because the abstractions are ****
-    task_ptr->priority = UINT32_MAX - current_clock();
-
     // If this process was interrupted in a msg queue, remove it from that queue
-    struct list_link *queue = queue_from_msg(task_ptr->pid);
-    if (queue != NULL) {
-        queue_del(task_ptr, tasks);
-    }
+    msg_task_exit(task_ptr);
 
     remove_from_global_list(task_ptr);
     free_pid(task_ptr->pid);
     set_task_return_value(task_ptr, retval);
     set_task_zombie(task_ptr);
+    orphan_children(task_ptr);
+    if (is_idle(task_ptr->parent))
+        set_zombie_orphan(task_ptr);
     unlock_interrupted_child_parent(task_ptr->parent);
     return 0;
 }
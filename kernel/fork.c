@@ -0,0 +1,183 @@
+/**
+ * Duplicate the calling process, or add a thread to it.
+ *
+ * A child made by fork() maps the same pages as its parent, copy-on-write:
+ * a page is only copied by the first of them to write to it (see
+ * copy_on_write in paging.c). Shared memory pages are not inherited.
+ * A thread shares the address space of its creator, with a stack of its own.
+ *
+ * Neither starts like a process made by start(): their kernel stack holds a
+ * syscall frame, under the address of fork_return (syscall_asm.S), where
+ * swtch returns to. fork_return returns 0 to user mode with the registers of
+ * the frame: for a child, a copy of the frame of the fork() syscall of its
+ * parent; for a thread, the entry point and the stack of the thread.
+ */
+
+#include "fork.h"
+#include "task.h"
+#include "pid_allocator.h"
+#include "errno.h"
+#include "paging.h"
+#include "page_allocator.h"
+#include "string.h"
+#include "start.h"
+#include "segment.h"
+#include "sched_group.h"
+#include "primitive.h"
+
+// Registers saved by syscall_isr (ebx, ecx, edx, esi, edi, ebp), and
+// interrupt frame pushed by the processor (eip, cs, eflags, esp, ss)
+#define SYSCALL_FRAME_WORDS 11
+#define FRAME_EIP 6
+#define FRAME_CS 7
+#define FRAME_EFLAGS 8
+#define FRAME_ESP 9
+#define FRAME_SS 10
+
+// Interrupts enabled, and the reserved bit 1
+#define USER_EFLAGS 0x202
+
+void fork_return(void);
+
+/**
+ * Create a task that will run for parent, scheduled like a process started
+ * by it, with no address space yet.
+ */
+static struct task *__clone_task(struct task *parent, int prio)
+{
+    struct task *child;
+    pid_t        pid;
+
+    pid = alloc_pid();
+    if (pid < 0)
+        return NULL;
+
+    child = alloc_empty_task();
+    if (!child) {
+        free_pid(pid);
+        return NULL;
+    }
+
+    set_task_starting_up(child);
+    set_task_name(child, parent->comm);
+    set_task_pid(child, pid);
+    set_task_priority(child, prio);
+    child->base_priority = prio;
+    refill_time_slice(child);
+    set_parent_process(child, parent);
+    // Same scheduling as start(): no inherited CPU reservation.
+    if (parent->sched_class != SCHED_DEADLINE)
+        set_task_sched_class(child, parent->sched_class, parent->weight);
+    if (parent->group)
+        sched_group_join(child, parent->group);
+    child->first_start = false;
+    child->msg_val     = -1;
+
+    child->kernel_stack = alloc_kernel_stack();
+    child->regs[ESP0]   = (uint32_t)child->kernel_stack + KSTACK_SZ - 1;
+    return child;
+}
+
+/**
+ * Get the syscall frame at the top of the kernel stack of a task.
+ */
+static uint32_t *__syscall_frame(struct task *task_ptr)
+{
+    return (uint32_t *)(task_ptr->regs[ESP0]) - SYSCALL_FRAME_WORDS;
+}
+
+/**
+ * Make the task return from the syscall frame at the top of its kernel
+ * stack when it first runs.
+ */
+static void __run_task(struct task *parent, struct task *child)
+{
+    uint32_t *frame = __syscall_frame(child);
+
+    frame[-1]        = (uint32_t)fork_return;
+    child->regs[ESP] = (uint32_t)(frame - 1);
+
+    set_task_ready(child);
+    add_to_global_list(child);
+
+    if (!task_outranks(parent, child))
+        schedule();
+}
+
+int fork(void)
+{
+    struct task       *parent = current();
+    struct task       *child;
+    struct user_space *space;
+    int                pid;
+
+    // Address space: code and the stack of the calling thread, copy-on-write.
+    space = user_space_clone(parent->space, parent->stack_slot);
+    if (!space)
+        return -ENOMEM;
+
+    child = __clone_task(parent, parent->base_priority);
+    if (!child) {
+        user_space_put(space);
+        return -EAGAIN;
+    }
+
+    child->space      = space;
+    child->stack_slot = parent->stack_slot;
+    child->regs[CR3]  = (uint32_t)child->space->dir;
+
+    memcpy(__syscall_frame(child), __syscall_frame(parent),
+           SYSCALL_FRAME_WORDS * sizeof(uint32_t));
+
+    pid = child->pid;
+    __run_task(parent, child);
+    return pid;
+}
+
+int sys_thread_create(int (*func)(void *), unsigned long ssize, int prio,
+                      void *arg, void (*start)(void))
+{
+    struct task *parent = current();
+    struct task *thread;
+    uint32_t    *stack_top;
+    uint32_t    *frame;
+    int          stack_slot;
+    int          pid;
+
+    if (ssize > USTACK_SZ_MAX)
+        return -EINVAL;
+    if (prio > MAX_PRIO || prio < MIN_PRIO)
+        return -EINVAL;
+
+    // The stack holds the arguments of start: func and arg.
+    stack_slot =
+        user_stack_create(parent->space, ssize * 4 + 3 * 4, &stack_top);
+    if (stack_slot < 0)
+        return -EAGAIN;
+
+    thread = __clone_task(parent, prio);
+    if (!thread) {
+        user_stack_destroy(parent->space, stack_slot);
+        return -EAGAIN;
+    }
+    stack_top[PAGE_SIZE / 4 - 1] = (uint32_t)arg;
+    stack_top[PAGE_SIZE / 4 - 2] = (uint32_t)func;
+    stack_top[PAGE_SIZE / 4 - 3] = 0; // Unused return address
+
+    thread->stack_slot = stack_slot;
+    user_space_get(parent->space);
+    thread->space     = parent->space;
+    thread->regs[CR3] = (uint32_t)parent->space->dir;
+
+    frame = __syscall_frame(thread);
+    memset(frame, 0, SYSCALL_FRAME_WORDS * sizeof(uint32_t));
+    frame[FRAME_EIP]    = (uint32_t)start;
+    frame[FRAME_CS]     = USER_CS;
+    frame[FRAME_EFLAGS] = USER_EFLAGS;
+    frame[FRAME_ESP]    = STACK_SLOT_TOP(thread->stack_slot) - 3 * 4;
+    frame[FRAME_SS]     = USER_DS;
+
+    pid = thread->pid;
+    __run_task(parent, thread);
+    return pid;
+}
@@ -0,0 +1,14 @@
+#ifndef __FORK_H__
+#define __FORK_H__
+
+int fork(void);
+/**
+ * Kernel side of thread_create (see primitive.h). start is the entry point
+ * of the thread in user mode, called with func and arg as arguments: the
+ * user library passes a function that calls exit with the return value of
+ * func.
+ */
+int sys_thread_create(int (*func)(void *), unsigned long ssize, int prio,
+                      void *arg, void (*start)(void));
+
+#endif
@@ -10,6 +10,7 @@
 #include "stddef.h"
 #include "string.h"
 #include "mem.h"
+#include "slab.h"
 
 
 #define HASH_MINSIZE 8
@@ -22,6 +23,30 @@ enum slot_mode {
 };
 
 
+/*
+ * Les tableaux de taille minimale, ceux de la plupart des tables, sont
+ * pris dans un cache d'objets, les autres dans le tas.
+ */
+static struct slab_cache slot_cache =
+        SLAB_CACHE_INIT(slot_cache, "hash_slots",
+                        HASH_MINSIZE * sizeof(hash_slot_t));
+
+static hash_slot_t *hash_table_alloc(long size)
+{
+        if (size == HASH_MINSIZE)
+                return slab_alloc(&slot_cache);
+        return mem_alloc(size * sizeof(hash_slot_t));
+}
+
+static void hash_table_free(hash_slot_t *table, long size)
+{
+        if (size == HASH_MINSIZE)
+                slab_free(&slot_cache, table);
+        else
+                mem_free(table, size * sizeof(hash_slot_t));
+}
+
+
 /*
  * Réinitialise une table avec un tableau interne de taille <size>.
  * Si l'allocation échoue, retourne -1 et laisse <map> inchangée.
@@ -29,7 +54,7 @@ enum slot_mode {
 static int hash_initialize(hash_t *map, long size)
 {
         long i;
-        hash_slot_t *table = mem_alloc(size * sizeof(hash_slot_t));
+        hash_slot_t *table = hash_table_alloc(size);
         if (table == NULL)
                 return -1;
 
@@ -130,7 +155,7 @@ static int hash_update(hash_t *map)
                 return -1;
 
         hash_copy(map, old_table, old_size);
-        mem_free(old_table, old_size * sizeof(hash_slot_t));
+        hash_table_free(old_table, old_size);
         return 0;
 }
 
@@ -150,7 +175,7 @@ int hash_init(hash_t *map, hash_func_t hfunc, hash_compare_t cmp)
 void hash_destroy(hash_t *map)
 {
         int size = map->mask+1;
-        mem_free(map->table, size * sizeof(hash_slot_t));
+        hash_table_free(map->table, size);
         map->fill  = 0;
         map->count = 0;
         map->mask  = 0;
@@ -1,11 +1,17 @@
 #include "msg.h"
 #include "task.h"
-#include "mem.h"
+#include "slab.h"
 
 #define __MQUEUE_UNUSED 0
 
 static struct mqueue *mqueues[NBQUEUE] = { __MQUEUE_UNUSED };
 
+// A message is allocated for each value waiting in a queue
+static struct slab_cache mqueue_cache =
+    SLAB_CACHE_INIT(mqueue_cache, "mqueue", sizeof(struct mqueue));
+static struct slab_cache msg_cache =
+    SLAB_CACHE_INIT(msg_cache, "msg", sizeof(struct msg));
+
 static int cpt_rst = 0;
 
 #define GET_MQUEUE_PTR(id) (mqueues[id])
@@ -25,31 +31,38 @@ static int first_available_queue(void)
     return -1;
 }
 
-static void alloc_mqueue(int mqueue_id, int count)
+/**
+ * @return -1 if out of memory, else 0
+ */
+static int alloc_mqueue(int mqueue_id, int count)
 {
-    struct mqueue *mqueue_ptr =
-        (struct mqueue *)mem_alloc(sizeof(struct mqueue));
+    struct mqueue *mqueue_ptr = slab_alloc(&mqueue_cache);
+    if (mqueue_ptr == NULL)
+        return -1;
     mqueue_ptr->head = NULL;
     mqueue_ptr->size = count;
     mqueue_ptr->count = 0;
     INIT_LIST_HEAD(&mqueue_ptr->waiting_senders);
     INIT_LIST_HEAD(&mqueue_ptr->waiting_receivers);
+    mqueue_ptr->proto         = MSG_PROTO_NONE;
+    mqueue_ptr->ceiling       = MIN_PRIO;
+    mqueue_ptr->last_sender   = -1;
+    mqueue_ptr->last_receiver = -1;
     SET_MQUEUE_PTR(mqueue_id, mqueue_ptr);
+    return 0;
 }
 
 static void free_mqueue(int mqueue_id)
 {
     struct mqueue *mqueue_ptr = GET_MQUEUE_PTR(mqueue_id);
-    if (!MQUEUE_EMPTY(mqueue_id)) {
-        struct msg *msg_ptr = mqueue_ptr->head;
+    struct msg    *msg_ptr    = mqueue_ptr->head;
+    while (mqueue_ptr->count > 0) {
         struct msg *next = msg_ptr->next;
-        while (next != NULL) {
-            next = msg_ptr->next;
-            mem_free(msg_ptr, sizeof(struct msg));
-            msg_ptr = next;
-        }
+        slab_free(&msg_cache, msg_ptr);
+        msg_ptr = next;
+        mqueue_ptr->count--;
     }
-    mem_free(mqueue_ptr, sizeof(struct mqueue));
+    slab_free(&mqueue_cache, mqueue_ptr);
     GET_MQUEUE_PTR(mqueue_id) = __MQUEUE_UNUSED;
 }
 
@@ -62,15 +75,22 @@ int pcreate(int count)
         return -2;
     if ((mqueue_id = first_available_queue()) == -1)
         return -1;
-    alloc_mqueue(mqueue_id, count);
+    if (alloc_mqueue(mqueue_id, count) < 0)
+        return -4;
     return mqueue_id;
 }
 
-static void __add_msg(int id, int msg)
+/**
+ * @return -1 if out of memory, else 0
+ */
+static int __add_msg(int id, int msg)
 {
     struct mqueue *mqueue_ptr = GET_MQUEUE_PTR(id);
-    struct msg *msg_ptr = mem_alloc(sizeof(struct msg));
+    struct msg *msg_ptr = slab_alloc(&msg_cache);
+    if (msg_ptr == NULL)
+        return -1;
     msg_ptr->data = msg;
+    msg_ptr->next = NULL;
 
     if (mqueue_ptr->count == 0) {
         mqueue_ptr->head = msg_ptr;
@@ -81,6 +101,7 @@ static void __add_msg(int id, int msg)
     }
 
     mqueue_ptr->count++;
+    return 0;
 }
 
 static int __pop_msg(int id)
@@ -88,12 +109,209 @@ static int __pop_msg(int id)
     struct mqueue *mqueue_ptr = GET_MQUEUE_PTR(id);
     mqueue_ptr->count--;
 
-    int msg = mqueue_ptr->head->data;
-    mqueue_ptr->head = mqueue_ptr->head->next;
+    struct msg *msg_ptr = mqueue_ptr->head;
+    int msg = msg_ptr->data;
+    mqueue_ptr->head = msg_ptr->next;
+    slab_free(&msg_cache, msg_ptr);
 
     return msg;
 }
 
+/*********************
+* Priority protocols *
+*********************/
+
+// Longest chain of blocked tasks along which a priority change is passed
+#define MSG_BOOST_DEPTH 8
+
+/**
+ * Priority that the tasks of a waiting list give to the task they wait for,
+ * MIN_PRIO if there are none. A task waiting for itself does not count.
+ */
+static int __waiters_priority(struct mqueue *mqueue_ptr,
+                              struct list_link *waiters, struct task *self)
+{
+    struct task *p;
+    int          prio = MIN_PRIO;
+
+    queue_for_each(p, waiters, struct task, tasks)
+    {
+        if (p == self)
+            continue;
+        if (mqueue_ptr->proto == MSG_PROTO_CEILING)
+            return mqueue_ptr->ceiling;
+        if (p->priority > prio)
+            prio = p->priority;
+    }
+    return prio;
+}
+
+int msg_inherited_priority(struct task *task_ptr)
+{
+    int prio = task_ptr->base_priority;
+    int waiters_prio;
+
+    for (int i = 0; i < NBQUEUE; i++) {
+        struct mqueue *mqueue_ptr = GET_MQUEUE_PTR(i);
+
+        if (MQUEUE_UNUSED(i) || mqueue_ptr->proto == MSG_PROTO_NONE)
+            continue;
+
+        if (mqueue_ptr->last_sender == task_ptr->pid) {
+            waiters_prio = __waiters_priority(
+                mqueue_ptr, &mqueue_ptr->waiting_receivers, task_ptr);
+            if (waiters_prio > prio)
+                prio = waiters_prio;
+        }
+        if (mqueue_ptr->last_receiver == task_ptr->pid) {
+            waiters_prio = __waiters_priority(
+                mqueue_ptr, &mqueue_ptr->waiting_senders, task_ptr);
+            if (waiters_prio > prio)
+                prio = waiters_prio;
+        }
+    }
+    return prio;
+}
+
+/**
+ * Task that the tasks of a waiting list wait for, -1 if none.
+ */
+static pid_t __waited_pid(struct list_link *waiters)
+{
+    for (int i = 0; i < NBQUEUE; i++) {
+        struct mqueue *mqueue_ptr = GET_MQUEUE_PTR(i);
+
+        if (MQUEUE_UNUSED(i))
+            continue;
+        if (waiters == &mqueue_ptr->waiting_senders)
+            return mqueue_ptr->last_receiver;
+        if (waiters == &mqueue_ptr->waiting_receivers)
+            return mqueue_ptr->last_sender;
+    }
+    return -1;
+}
+
+static void __update_priority(pid_t pid, int depth);
+
+/**
+ * Pass a priority change of a blocked task on to the task it waits for.
+ */
+static void __update_waited(struct task *waiter, int depth)
+{
+    if (depth < MSG_BOOST_DEPTH)
+        __update_priority(__waited_pid(queue_from_msg(waiter->pid)),
+                          depth + 1);
+}
+
+/**
+ * Give a task the priority it inherits now. If it is itself blocked on a
+ * queue, the task it waits for may inherit the change in turn.
+ */
+static void __update_priority(pid_t pid, int depth)
+{
+    struct task      *task_ptr = pid_to_task(pid);
+    struct list_link *queue_head;
+    int               prio;
+
+    if (!task_ptr || is_idle(task_ptr) || is_task_zombie(task_ptr))
+        return;
+
+    prio = msg_inherited_priority(task_ptr);
+    if (prio == task_ptr->priority)
+        return;
+
+    set_task_priority(task_ptr, prio);
+    queue_head = queue_from_state(task_ptr->state, task_ptr->pid);
+    if (queue_head)
+        queue_update(task_ptr, queue_head, struct task, tasks, priority);
+    if (is_task_interrupted_msg(task_ptr))
+        __update_waited(task_ptr, depth);
+}
+
+/**
+ * Update the priorities of the producer and consumer of a queue, after tasks
+ * started or stopped waiting for them.
+ */
+static void __update_waited_by(struct mqueue *mqueue_ptr)
+{
+    if (mqueue_ptr->proto == MSG_PROTO_NONE)
+        return;
+    __update_priority(mqueue_ptr->last_sender, 0);
+    __update_priority(mqueue_ptr->last_receiver, 0);
+}
+
+/**
+ * Record the current task as the producer or consumer of a queue: the tasks
+ * blocked on it now wait for the current task instead of the previous one.
+ */
+static void __set_waited(struct mqueue *mqueue_ptr, pid_t *waited)
+{
+    pid_t old = *waited;
+
+    if (old == current()->pid)
+        return;
+    *waited = current()->pid;
+    if (mqueue_ptr->proto == MSG_PROTO_NONE)
+        return;
+    __update_priority(old, 0);
+    __update_priority(current()->pid, 0);
+}
+
+void msg_priority_changed(struct task *task_ptr)
+{
+    __update_waited(task_ptr, 0);
+}
+
+void msg_task_exit(struct task *task_ptr)
+{
+    struct list_link *waiters = queue_from_msg(task_ptr->pid);
+
+    if (waiters != NULL) {
+        pid_t waited = __waited_pid(waiters);
+        queue_del(task_ptr, tasks);
+        __update_priority(waited, 0);
+    }
+
+    // Its pid may be given to another task, which must not inherit anything.
+    for (int i = 0; i < NBQUEUE; i++) {
+        struct mqueue *mqueue_ptr = GET_MQUEUE_PTR(i);
+
+        if (MQUEUE_UNUSED(i))
+            continue;
+        if (mqueue_ptr->last_sender == task_ptr->pid)
+            mqueue_ptr->last_sender = -1;
+        if (mqueue_ptr->last_receiver == task_ptr->pid)
+            mqueue_ptr->last_receiver = -1;
+    }
+}
+
+int psetproto(int id, int proto, int ceiling)
+{
+    struct mqueue *mqueue_ptr;
+    struct task   *highest_prio_ready;
+
+    if (id < 0 || id >= NBQUEUE || MQUEUE_UNUSED(id))
+        return -1;
+    if (proto != MSG_PROTO_NONE && proto != MSG_PROTO_INHERIT &&
+        proto != MSG_PROTO_CEILING)
+        return -1;
+    if (proto == MSG_PROTO_CEILING &&
+        (ceiling < MIN_PRIO || ceiling > MAX_PRIO))
+        return -1;
+
+    mqueue_ptr = GET_MQUEUE_PTR(id);
+    mqueue_ptr->proto   = proto;
+    mqueue_ptr->ceiling = ceiling;
+    // Boosts given under the previous protocol may end now.
+    __update_priority(mqueue_ptr->last_sender, 0);
+    __update_priority(mqueue_ptr->last_receiver, 0);
+
+    highest_prio_ready = ready_queue_top();
+    if (highest_prio_ready && task_outranks(highest_prio_ready, current()))
+        schedule();
+    return 0;
+}
+
 int psend(int id, int msg)
 {
     int rst = cpt_rst;
@@ -101,10 +319,13 @@ int psend(int id, int msg)
     if (MQUEUE_UNUSED(id))
         return -1;
 
+    __set_waited(GET_MQUEUE_PTR(id), &GET_MQUEUE_PTR(id)->last_sender);
+
     // Cas process en attente
     if(!queue_empty(&GET_MQUEUE_PTR(id)->waiting_receivers)){
         struct task *last = queue_out(&GET_MQUEUE_PTR(id)->waiting_receivers, struct task, tasks);
         last->msg_val = msg;
+        __update_waited_by(GET_MQUEUE_PTR(id));
         set_task_ready_or_running(last);
         return 0;
     }
@@ -113,6 +334,7 @@ int psend(int id, int msg)
     while (MQUEUE_FULL(id) && (current()->msg_val != -1)) {
         queue_add(current(), &GET_MQUEUE_PTR(id)->waiting_senders, struct task,
                   tasks, priority);
+        __update_waited_by(GET_MQUEUE_PTR(id));
         set_task_interrupted_msg(current());
     }
 
@@ -124,13 +346,17 @@ int psend(int id, int msg)
         return 0;
     }
 
+    // Le message est en file avant de réveiller un lecteur, qui le trouve
+    if (__add_msg(id, msg) < 0)
+        return -1;
+
     // On réveille un processus en attente sur la lecture s'il y en a
     struct task *last =
         queue_out(&GET_MQUEUE_PTR(id)->waiting_receivers, struct task, tasks);
-    if (last != NULL)
+    if (last != NULL) {
+        __update_waited_by(GET_MQUEUE_PTR(id));
         set_task_ready_or_running(last);
-
-    __add_msg(id, msg);
+    }
 
     return 0;
 }
@@ -142,10 +368,13 @@ int preceive(int id, int *message)
     if (MQUEUE_UNUSED(id))
         return -1;
 
+    __set_waited(GET_MQUEUE_PTR(id), &GET_MQUEUE_PTR(id)->last_receiver);
+
     current()->msg_val = -1;
     while (MQUEUE_EMPTY(id) && (current()->msg_val == -1)) {
         queue_add(current(), &GET_MQUEUE_PTR(id)->waiting_receivers,
                   struct task, tasks, priority);
+        __update_waited_by(GET_MQUEUE_PTR(id));
         set_task_interrupted_msg(current());
     }
 
@@ -168,6 +397,7 @@ int preceive(int id, int *message)
     int msg;
     if (last != NULL) {
         if(MQUEUE_FULL(id)&&(last->msg_val!=-1)){
+            // L'objet libéré par __pop_msg est repris : pas d'échec
             msg = __pop_msg(id);
             __add_msg(id,last->msg_val);
             last->msg_val = -1;
@@ -177,6 +407,7 @@ int preceive(int id, int *message)
         } else {
             msg = __pop_msg(id);
         }
+        __update_waited_by(GET_MQUEUE_PTR(id));
         set_task_ready_or_running(last);
     } else {
         msg = __pop_msg(id);
@@ -211,6 +442,9 @@ int pdelete(int id)
                          tasks);
     }
 
+    // Plus personne n'attend le producteur et le consommateur
+    __update_waited_by(GET_MQUEUE_PTR(id));
+
     // Liberer les ressources
     free_mqueue(id);
 
@@ -253,9 +487,13 @@ int preset(int id)
 
     cpt_rst++;
 
-    int count = GET_MQUEUE_PTR(id)->count;
+    int count   = GET_MQUEUE_PTR(id)->count;
+    int proto   = GET_MQUEUE_PTR(id)->proto;
+    int ceiling = GET_MQUEUE_PTR(id)->ceiling;
     pdelete(id);
     alloc_mqueue(id, count);
+    GET_MQUEUE_PTR(id)->proto   = proto;
+    GET_MQUEUE_PTR(id)->ceiling = ceiling;
 
     return 0;
 }
@@ -13,6 +13,13 @@ struct mqueue {
     unsigned int count; /* Number of messages */
     struct list_link waiting_senders;
     struct list_link waiting_receivers;
+    /* Priority protocol, see psetproto(), and its ceiling priority */
+    int proto;
+    int ceiling;
+    /* Last producer and consumer, that blocked receivers and senders wait
+     * for, -1 if none */
+    pid_t last_sender;
+    pid_t last_receiver;
 };
 
 struct msg {
@@ -38,6 +45,9 @@ int preset(int id);
 // Renvoie l'état courant d'une file
 int pcount(int id, int *count);
 
+// Choisit le protocole de priorité d'une file
+int psetproto(int id, int proto, int ceiling);
+
 // Renvoie la liste dans laquelle le pid est présent
 struct list_link *queue_from_msg(int pid);
 
@@ -45,6 +55,21 @@ struct list_link *queue_from_msg(int pid);
  * Delete and reinsert a process in a message queue.
  */
 void msg_reinsert(struct task *self);
+/**
+ * Priority of a task, raised to the one it inherits from the tasks blocked on
+ * the message queues it produces for or consumes from.
+ */
+int msg_inherited_priority(struct task *task_ptr);
+/**
+ * Propagate a priority change of a task blocked on a message queue to the
+ * task it waits for.
+ */
+void msg_priority_changed(struct task *task_ptr);
+/**
+ * Forget a dying task: stop its wait on a message queue, and the boosts of
+ * the tasks that waited for it.
+ */
+void msg_task_exit(struct task *task_ptr);
 /**
  * Get the queue for a msg queue, useful to allow
  * modification (deleting the task...)
@@ -0,0 +1,30 @@
+#include <stddef.h>
+
+#include "obj_cache.h"
+#include "mem.h"
+
+void *obj_cache_alloc(struct obj_cache *cache)
+{
+    void *obj;
+
+    if (cache->nb_objects > 0)
+        return cache->objects[--cache->nb_objects];
+
+    obj = cache->alloc ? cache->alloc(cache->size) : mem_alloc(cache->size);
+    if (obj && cache->ctor)
+        cache->ctor(obj);
+    return obj;
+}
+
+void obj_cache_free(struct obj_cache *cache, void *obj)
+{
+    if (cache->nb_objects < OBJ_CACHE_SIZE) {
+        cache->objects[cache->nb_objects++] = obj;
+        return;
+    }
+
+    if (cache->free)
+        cache->free(obj, cache->size);
+    else
+        mem_free(obj, cache->size);
+}
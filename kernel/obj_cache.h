@@ -0,0 +1,50 @@
+#ifndef __OBJ_CACHE_H__
+#define __OBJ_CACHE_H__
+
+#include "parameters.h"
+
+/**
+ * Cache of objects of one type, kept constructed between uses.
+ *
+ * ctor runs once, when an object is taken from the backing allocator: the
+ * cache hands out objects in that state, and they must be given back in it.
+ * Up to OBJ_CACHE_SIZE freed objects are kept for the next allocations;
+ * beyond that, they go back to the backing allocator.
+ */
+struct obj_cache {
+    const char   *name;
+    unsigned long size;
+    void (*ctor)(void *obj);
+    // Backing allocator, mem_alloc and mem_free if NULL
+    void *(*alloc)(unsigned long size);
+    void (*free)(void *obj, unsigned long size);
+    void *objects[OBJ_CACHE_SIZE];
+    int   nb_objects;
+};
+
+/**
+ * Static initializer of a cache.
+ * @param name Name of the cache, for debugging.
+ * @param size Size of an object, in bytes.
+ * @param ctor Constructor of the objects, or NULL.
+ * @param alloc Backing allocator, or NULL for mem_alloc.
+ * @param free Release function of the backing allocator, or NULL for
+ * mem_free.
+ */
+#define OBJ_CACHE_INIT(name, size, ctor, alloc, free)                         \
+    {                                                                          \
+        (name), (size), (ctor), (alloc), (free), { 0 }, 0                      \
+    }
+
+/**
+ * Get an object, constructed.
+ * @return NULL if the backing allocator is out of memory.
+ */
+void *obj_cache_alloc(struct obj_cache *cache);
+
+/**
+ * Give an object back to its cache. It must be in its constructed state.
+ */
+void obj_cache_free(struct obj_cache *cache, void *obj);
+
+#endif
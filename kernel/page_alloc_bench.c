@@ -0,0 +1,80 @@
+/**
+ * Microbenchmark of the physical page allocator, run at boot when
+ * PAGE_ALLOC_BENCH is defined (see parameters.h).
+ *
+ * A table of slots is filled and emptied at random: each round picks a slot,
+ * frees its block if it holds one, or allocates a block of 1 to
+ * BENCH_MAX_PAGES pages. The allocator ends up with fragmented free lists,
+ * as after a long run of process starts and exits. The mean cost of an
+ * allocation and of a free is printed, in processor cycles.
+ */
+
+#include "parameters.h"
+
+#ifdef PAGE_ALLOC_BENCH
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "page_allocator.h"
+#include "cpu.h"
+#include "div64.h"
+
+#define BENCH_SLOTS 1024
+#define BENCH_ROUNDS 100000
+#define BENCH_MAX_PAGES 16
+
+static void    *blocks[BENCH_SLOTS];
+static int      sizes[BENCH_SLOTS];
+static uint32_t seed = 2463534242u;
+
+// xorshift32: the kernel has no rand()
+static uint32_t __random(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+void page_alloc_bench(void)
+{
+    unsigned long long alloc_cycles = 0;
+    unsigned long long free_cycles  = 0;
+    unsigned long long stamp;
+    unsigned long      nb_allocs = 0;
+    unsigned long      nb_frees  = 0;
+
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        int slot = __random() % BENCH_SLOTS;
+
+        if (blocks[slot]) {
+            stamp = rdtsc();
+            free_physical_page(blocks[slot], sizes[slot]);
+            free_cycles += rdtsc() - stamp;
+            nb_frees++;
+            blocks[slot] = NULL;
+        } else {
+            sizes[slot] = 1 + __random() % BENCH_MAX_PAGES;
+            stamp       = rdtsc();
+            blocks[slot] = alloc_physical_page(sizes[slot]);
+            alloc_cycles += rdtsc() - stamp;
+            nb_allocs++;
+        }
+    }
+
+    for (int slot = 0; slot < BENCH_SLOTS; slot++) {
+        if (blocks[slot]) {
+            free_physical_page(blocks[slot], sizes[slot]);
+            blocks[slot] = NULL;
+        }
+    }
+
+    printf("page allocator: %lu allocs, %lu cycles each; "
+           "%lu frees, %lu cycles each\n",
+           nb_allocs, (unsigned long)div64(alloc_cycles, nb_allocs), nb_frees,
+           (unsigned long)div64(free_cycles, nb_frees));
+}
+
+#endif
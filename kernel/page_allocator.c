@@ -1,61 +1,81 @@
 #include <stdint.h>
+#include <stdbool.h>
 #include "mem.h"
 #include "page_allocator.h"
+#include "queue.h"
 #include "stdio.h"
 #include "stddef.h"
+#include "multiboot.h"
 
 /**
 * Buddy algorithm to alloc pages
  * Pages have a minimum size of 4096
- * and are located between 0x4000000 and 0x10000000.
- * The size of the given block is 0xc000000, and it's not a power of two.
- * That's why we divide this blocks in three block of 0x4000000 size
- * and we apply the buddy algorithm on these blocks
+ * and are located between 0x4000000 (the end of the kernel heap) and
+ * 0x40000000 (the start of user space: the kernel cannot map pages above).
+ * The RAM of this range is given by the memory map of the bootloader:
+ * each usable region is split in the largest aligned blocks it holds, up
+ * to 0x4000000 bytes, and we apply the buddy algorithm on these blocks
  * In alloc_pf, you need to allocate a number of pages you want
  * (ie the number of bloc of 4096)
+ * A block is rounded up to a power of two pages, but the pages beyond the
+ * ones asked for are freed right away: an allocation of n pages uses n
+ * pages, and can be freed in parts.
+ *
+ * Each page frame has a struct page. The first page of a free block records
+ * the order of the block, and links it in the free list of its order: the
+ * buddy of a block is found, and taken off its list, in constant time.
 */
 
 #define FIRST_ADDRESS 0x4000000
-#define SECOND_ADDRESS 0x8000000
-#define THIRD_ADDRESS 0xc000000
 
 #define NB_PAGES_ALLOC 0x4000
 #define MAP_SIZE 15
 #define SHIFT 12
 
-struct free_area {
-    void *map[MAP_SIZE];
-    int   nb_alloc;
+// End of the memory managed by the allocator
+#define LAST_ADDRESS 0x40000000
+
+#define NB_FRAMES ((LAST_ADDRESS - FIRST_ADDRESS) >> SHIFT)
+
+// Order of a page that is not the first page of a free block
+#define NOT_FREE -1
+
+struct page {
+    // Link in the free list of its order, if the page starts a free block
+    link     free_link;
+    int8_t   order;
+    // References to the page besides the one of whoever allocated it:
+    // pages shared copy-on-write are freed with their last one.
+    uint16_t refs;
 };
 
-//list of free page area
-struct free_area area;
+static struct page pages[NB_FRAMES];
 
-void init_alloc()
+// Free blocks of 2^index pages
+static link free_lists[MAP_SIZE];
+
+// Pages in the free lists
+static unsigned long nb_free_pages = 0;
+
+static bool initialized = false;
+
+#define PAGE_INDEX(addr) (((uint32_t)(addr)-FIRST_ADDRESS) >> SHIFT)
+#define PAGE_ADDRESS(index) ((void *)(FIRST_ADDRESS + ((index) << SHIFT)))
+
+#define PAGE_REFS(page) (pages[PAGE_INDEX(page)].refs)
+
+static void __free_list_add(uint32_t index, uint32_t order)
 {
-    if (area.nb_alloc == 0) {
-        area.map[MAP_SIZE - 1] = (void *)FIRST_ADDRESS;
-        // just one block
-        *((void **)area.map[MAP_SIZE - 1]) = NULL;
-        area.nb_alloc++;
-    }
+    pages[index].order = order;
+    queue_add_tail(&pages[index], &free_lists[order], free_link);
+    nb_free_pages += 1 << order;
 }
 
-void alloc_block()
+static void __free_list_del(uint32_t index)
 {
-    if (area.nb_alloc == 1) {
-        area.map[MAP_SIZE - 1] = (void *)SECOND_ADDRESS;
-        // just one block
-        *((void **)area.map[MAP_SIZE - 1]) = NULL;
-        area.nb_alloc++;
-    } else if (area.nb_alloc == 2) {
-        area.map[MAP_SIZE - 1] = (void *)THIRD_ADDRESS;
-        // just one block
-        *((void **)area.map[MAP_SIZE - 1]) = NULL;
-        area.nb_alloc++;
-    } else {
-        panic("can't allocate more pages");
-    }
+    queue_del(&pages[index], free_link);
+    nb_free_pages -= 1 << pages[index].order;
+    pages[index].order = NOT_FREE;
 }
 
 uint32_t puiss2(unsigned long size)
@@ -71,7 +91,122 @@ uint32_t puiss2(unsigned long size)
     return p;
 }
 
-void *alloc_physical_page(int nb_pages)
+/**
+ * Take a free block of 2^order pages, splitting a larger one if needed.
+ * @return the index of its first page, or NB_FRAMES if there is no block
+ * large enough.
+ */
+static uint32_t __buddy_alloc(uint32_t order)
+{
+    //find the first order where there is a block
+    uint32_t scan_order = order;
+    while (queue_empty(&free_lists[scan_order])) {
+        scan_order++;
+        if (scan_order == MAP_SIZE)
+            return NB_FRAMES;
+    }
+
+    struct page *block = queue_top(&free_lists[scan_order], struct page,
+                                   free_link);
+    uint32_t     index = block - pages;
+    __free_list_del(index);
+
+    // Split blocks until to have the needed size: the upper halves are free
+    while (scan_order != order) {
+        scan_order--;
+        __free_list_add(index + (1 << scan_order), scan_order);
+    }
+
+    return index;
+}
+
+/**
+ * Give back a block of 2^order pages, merged with its buddy while it is
+ * free.
+ */
+static void __buddy_free(uint32_t index, uint32_t order)
+{
+    // The largest blocks are the arenas: they are never merged.
+    while (order < MAP_SIZE - 1) {
+        uint32_t buddy = index ^ (1 << order);
+
+        if (pages[buddy].order != (int8_t)order)
+            break;
+
+        __free_list_del(buddy);
+        index &= ~(1 << order);
+        order++;
+    }
+    __free_list_add(index, order);
+}
+
+/**
+ * Give back nb_pages pages from index, as the largest aligned blocks they
+ * hold.
+ */
+static void __free_range(uint32_t index, int nb_pages)
+{
+    while (nb_pages > 0) {
+        uint32_t order = 0;
+
+        while (order + 1 < MAP_SIZE && !(index & (1 << order)) &&
+               (1 << (order + 1)) <= nb_pages)
+            order++;
+
+        __buddy_free(index, order);
+        index += 1 << order;
+        nb_pages -= 1 << order;
+    }
+}
+
+/**
+ * Give the pages of [start, end) to the allocator, if they are in its range.
+ */
+static void __add_region(uint64_t start, uint64_t end)
+{
+    if (start < FIRST_ADDRESS)
+        start = FIRST_ADDRESS;
+    if (end > LAST_ADDRESS)
+        end = LAST_ADDRESS;
+
+    // Only whole pages
+    start = (start + (1 << SHIFT) - 1) & ~((1 << SHIFT) - 1);
+    end &= ~((1 << SHIFT) - 1);
+    if (start >= end)
+        return;
+
+    __free_range(PAGE_INDEX(start), (end - start) >> SHIFT);
+}
+
+void init_alloc()
+{
+    const multiboot_memory_map_t *mmap;
+    unsigned                      nb_entries;
+
+    if (initialized)
+        return;
+
+    for (int order = 0; order < MAP_SIZE; order++)
+        INIT_LIST_HEAD(&free_lists[order]);
+    for (uint32_t index = 0; index < NB_FRAMES; index++) {
+        INIT_LINK(&pages[index].free_link);
+        pages[index].order = NOT_FREE;
+        pages[index].refs  = 0;
+    }
+    initialized = true;
+
+    // Usable RAM according to the bootloader, or all the memory above 1MB
+    // if it gave no map.
+    nb_entries = multiboot_mmap(&mmap);
+    if (nb_entries == 0)
+        __add_region(0x100000, 0x100000 + multiboot_upper_mem() * 1024ull);
+    for (unsigned i = 0; i < nb_entries; i++) {
+        if (mmap[i].type == MULTIBOOT_MEMORY_AVAILABLE)
+            __add_region(mmap[i].addr, mmap[i].addr + mmap[i].len);
+    }
+}
+
+void *try_alloc_physical_page(int nb_pages)
 {
     init_alloc();
     assert(nb_pages > 0);
@@ -80,76 +215,56 @@ void *alloc_physical_page(int nb_pages)
     //size we want to allocate
     uint32_t size = nb_pages << SHIFT;
 
-    //index in the map (the index 0 correspond to a size of 4096 that's why we do -12)
-    uint32_t index = puiss2(size) - SHIFT;
+    //order of the block (the order 0 correspond to a size of 4096 that's why we do -12)
+    uint32_t order = puiss2(size) - SHIFT;
 
-    //find the first index where there is a block
-    uint32_t scan_index = index;
-    while (area.map[scan_index] == NULL) {
-        scan_index++;
+    uint32_t index = __buddy_alloc(order);
+    if (index == NB_FRAMES)
+        return NULL;
 
-        //reallocate memory if needed
-        if (scan_index == MAP_SIZE - 1 && area.map[scan_index] == NULL) {
-            alloc_block();
-            *((void **)area.map[scan_index]) = NULL;
-        }
-    }
+    // Only keep the pages asked for: the end of the block goes back to the
+    // free lists.
+    __free_range(index + nb_pages, (1 << order) - nb_pages);
 
-    // Split blocks until to have the needed size
-    while (scan_index != index) {
-        void *curr_block     = area.map[scan_index];
-        area.map[scan_index] = *((void **)curr_block);
-        scan_index--;
-        area.map[scan_index] = curr_block;
-
-        //Buddy calculation
-        uint32_t buddy_block =
-            (uint32_t)curr_block ^ (1 << (scan_index + SHIFT));
-        *((void **)area.map[scan_index]) = (void *)buddy_block;
-        *((void **)buddy_block)          = NULL;
-    }
+    return PAGE_ADDRESS(index);
+}
 
-    void *ptr       = area.map[index];
-    area.map[index] = *((void **)ptr);
+void *alloc_physical_page(int nb_pages)
+{
+    void *block = try_alloc_physical_page(nb_pages);
 
-    return ptr;
+    if (block == NULL)
+        panic("can't allocate more pages");
+    return block;
+}
+
+unsigned long free_physical_pages(void)
+{
+    init_alloc();
+    return nb_free_pages;
 }
 
 void free_physical_page(void *physical_page, int nb_pages)
 {
-    //size allocated
-    uint32_t size          = nb_pages << SHIFT;
-    uint32_t index         = puiss2(size) - SHIFT;
-    uint32_t buddy_address = ((uint32_t)physical_page) ^ (1 << (index + SHIFT));
-
-    void *scan_ptr     = area.map[index];
-    void *previous_ptr = NULL;
-    while (scan_ptr != NULL) {
-        if ((uint32_t)scan_ptr == buddy_address) {
-            // Buddy addr is found : regroup + init to do the same on index + 1
-            if (previous_ptr != NULL) {
-                *((void **)previous_ptr) = *((void **)scan_ptr);
-            } else {
-                area.map[index] = *((void **)scan_ptr);
-            }
-            index++;
-            if (index == MAP_SIZE) {
-                break;
-            }
-            physical_page = ((uint32_t)physical_page < buddy_address) ?
-                                physical_page :
-                                (void *)buddy_address;
-            scan_ptr      = area.map[index];
-            buddy_address = ((uint32_t)physical_page) ^ (1 << (index + SHIFT));
-            previous_ptr  = NULL;
-            continue;
-        }
-        previous_ptr = scan_ptr;
-        if (scan_ptr != NULL) {
-            scan_ptr = *((void **)scan_ptr);
-        }
+    __free_range(PAGE_INDEX(physical_page), nb_pages);
+}
+
+void get_physical_page(void *physical_page)
+{
+    assert(PAGE_REFS(physical_page) < UINT16_MAX);
+    PAGE_REFS(physical_page)++;
+}
+
+void put_physical_page(void *physical_page)
+{
+    if (PAGE_REFS(physical_page) == 0) {
+        free_physical_page(physical_page, 1);
+        return;
     }
-    void *next_ptr              = area.map[index];
-    area.map[index]             = physical_page;
-    *((void **)area.map[index]) = next_ptr;
+    PAGE_REFS(physical_page)--;
+}
+
+int physical_page_shared(void *physical_page)
+{
+    return PAGE_REFS(physical_page) != 0;
 }
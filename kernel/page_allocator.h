@@ -9,6 +9,18 @@
  */
 void * alloc_physical_page(int nb_pages);
 
+/**
+ * Alloc the number of page we want, if a block large enough is free
+ * @param nb_pages : the number of pages
+ * @return the address of the pages, or NULL
+ */
+void * try_alloc_physical_page(int nb_pages);
+
+/**
+ * Number of free pages, whatever the blocks they are in
+ */
+unsigned long free_physical_pages(void);
+
 /**
  * Free the block of pages allocate with the buddy algorithm
  * @param physical_page The address of the block
@@ -16,4 +28,30 @@ void * alloc_physical_page(int nb_pages);
  */
 void   free_physical_page(void *physical_page, int nb_pages);
 
+/**
+ * Add a reference to a page, for a new address space mapping it
+ * copy-on-write. Pages start with the one reference of their allocator.
+ * @param physical_page The address of the page
+ */
+void   get_physical_page(void *physical_page);
+
+/**
+ * Drop a reference to a page allocated alone, and free it with the last one.
+ * @param physical_page The address of the page
+ */
+void   put_physical_page(void *physical_page);
+
+/**
+ * Whether a page has more than one reference.
+ * @param physical_page The address of the page
+ */
+int    physical_page_shared(void *physical_page);
+
+#ifdef PAGE_ALLOC_BENCH
+/**
+ * Print the mean cost of allocations and frees under random churn.
+ */
+void   page_alloc_bench(void);
+#endif
+
 #endif
\ No newline at end of file
@@ -40,6 +40,10 @@
  * table / page directory,
  * you MUST mask the lower 12 bits, for example with `& 0xFFFFF000`.
  *
+ * With the LARGE flag (PSE), a page directory entry maps a 4MB page: the
+ * address is then that of the page, aligned on 4MB, and there is no page
+ * table.
+ *
  * Useful resources:
  * https://wiki.osdev.org/Paging
  * https://www.youtube.com/watch?v=dn55T2q63RU video on two tier system
@@ -54,12 +58,80 @@
 #include "exit.h"
 #include "cga.h"
 #include "primitive.h"
+#include "cpu.h"
+#include "task.h"
+#include "start.h"
+#include "mem.h"
+#include "obj_cache.h"
+#include "errno.h"
 
 // Align to page size.
 #define ALIGN(addr) ((addr)&0xFFFFF000)
 // Align to page size with rounding up. If it's already aligned, we don't
 // need to round it up.
 #define ALIGN_UP(addr) ((!((addr)&0xFFF) ? (addr) : ALIGN(addr)))
+// Round up to the next page boundary.
+#define ROUND_UP(addr) ALIGN((addr) + PAGE_SIZE - 1)
+// Align to large page size.
+#define LARGE_ALIGN(addr) ((addr) & ~(LARGE_PAGE_SIZE - 1))
+
+// Page fault error code bits
+#define PF_PRESENT 0x1
+#define PF_WRITE 0x2
+
+// Write protect bit of cr0: the kernel faults too when writing to a
+// read-only user page, so that copy-on-write also works for syscalls.
+#define CR0_WP 0x10000
+
+/**
+ * Get the page table entry of a virtual address, NULL if it has no page table
+ * (or is in a large page).
+ */
+static uint32_t *page_entry(uint32_t *dir, uint32_t virt_addr)
+{
+    uint32_t pd_index = virt_addr >> 22;
+    uint32_t pt_index = (virt_addr >> 12) & 0x3FF;
+
+    if (((uint32_t)dir[pd_index] & (PRESENT | LARGE)) != PRESENT)
+        return NULL;
+
+    return (uint32_t *)(dir[pd_index] & 0xFFFFF000) + pt_index;
+}
+
+/**
+ * Whether a virtual address is in a large page.
+ */
+static bool in_large_page(uint32_t *dir, uint32_t virt_addr)
+{
+    return (dir[virt_addr >> 22] & (PRESENT | LARGE)) == (PRESENT | LARGE);
+}
+
+/**
+ * Map the large page holding a virtual address, if any, with a page table
+ * instead: its 4Kb pages are then handled, and freed, one by one.
+ * @return -ENOMEM if the page allocator is out of memory for the page table,
+ * with the large page left as is, 0 otherwise.
+ */
+static int split_large_page(uint32_t *dir, uint32_t virt_addr)
+{
+    uint32_t  pd_index = virt_addr >> 22;
+    uint32_t  pde      = dir[pd_index];
+    uint32_t *page_table;
+
+    if (!in_large_page(dir, virt_addr))
+        return 0;
+
+    page_table = try_alloc_physical_page(1);
+    if (!page_table)
+        return -ENOMEM;
+    for (int i = 0; i < LARGE_PAGE_PAGES; i++) {
+        page_table[i] =
+            (LARGE_ALIGN(pde) + i * PAGE_SIZE) | (pde & (US | RW)) | PRESENT;
+    }
+    dir[pd_index] = (uint32_t)page_table | US | RW | PRESENT;
+    invlpg(LARGE_ALIGN(virt_addr));
+    return 0;
+}
 
 /**
  * Maps the specified page with given flags.
@@ -68,27 +140,42 @@
  * @param virt_addr The virtual adress to map
  * @param phy_addr The physical adress to map it to
  * @param flags Flags to set on the page
+ * @return -ENOMEM if a page table is needed and the page allocator is out of
+ * memory, 0 otherwise.
  */
-void map_page(uint32_t *dir, uint32_t virt_addr, uint32_t phy_addr,
-              uint32_t flags)
+static int __map_page(uint32_t *dir, uint32_t virt_addr, uint32_t phy_addr,
+                      uint32_t flags)
 {
     // First 10 bits: page directory (bits 31-22)
     uint32_t pd_index = virt_addr >> 22;
     // Next 12 bits: page table (bits 21-12)
     uint32_t pt_index = (virt_addr >> 12) & 0x3FF;
 
+    assert(!in_large_page(dir, virt_addr));
+
     // Check whether a page table entry is present
     if (((uint32_t)dir[pd_index] & PRESENT) == 0) {
         // If it's not, we'll create a new page table
-        uint32_t *pt_address = alloc_physical_page(1);
+        uint32_t *pt_address = try_alloc_physical_page(1);
+        if (!pt_address)
+            return -ENOMEM;
         memset(pt_address, 0, PAGE_SIZE);
-        dir[pd_index] = (uint32_t)pt_address | flags | PRESENT;
+        // Rights are checked on each page: the table must not restrict them.
+        dir[pd_index] = (uint32_t)pt_address | (flags & US) | RW | PRESENT;
     }
 
     // Get the page table adress: only upper 20 bits, bits 31-10
     uint32_t *page_table = (uint32_t *)(dir[pd_index] & 0xFFFFF000);
     // Set the physical adress in the page table with flags
     page_table[pt_index] = phy_addr | flags | PRESENT;
+    return 0;
+}
+
+void map_page(uint32_t *dir, uint32_t virt_addr, uint32_t phy_addr,
+              uint32_t flags)
+{
+    if (__map_page(dir, virt_addr, phy_addr, flags) < 0)
+        panic("can't allocate more pages");
 }
 
 void map_zone(uint32_t *pdir, uint64_t virt_start, uint64_t virt_end,
@@ -130,50 +217,699 @@ void unmap_zone(uint32_t *pdir, uint64_t virt_start, uint64_t virt_end)
     }
 }
 
-uint32_t *page_directory_create()
+int map_cow_pages(uint32_t *pdir, uint32_t virt_start, uint32_t **pages,
+                  int nb_pages)
 {
-    // Early page directory from early_mm.c
-    extern uint32_t pgdir[];
+    for (int i = 0; i < nb_pages; i++) {
+        get_physical_page(pages[i]);
+        if (__map_page(pdir, virt_start + i * PAGE_SIZE, (uint32_t)pages[i],
+                       COW | US) < 0) {
+            put_physical_page(pages[i]);
+            return -ENOMEM;
+        }
+    }
+    return 0;
+}
 
+int share_zone(uint32_t *dst, uint32_t *src, uint32_t virt_start,
+               uint32_t virt_end)
+{
+    for (uint64_t virt = ALIGN(virt_start); virt < virt_end; virt += PAGE_SIZE) {
+        uint32_t *pte;
+
+        if (!(src[virt >> 22] & PRESENT)) {
+            // Nothing mapped up to the next page table
+            virt = LARGE_ALIGN(virt) + LARGE_PAGE_SIZE - PAGE_SIZE;
+            continue;
+        }
+
+        // Pages are shared one by one.
+        if (split_large_page(src, virt) < 0)
+            return -ENOMEM;
+        pte = page_entry(src, virt);
+        if (!(*pte & PRESENT))
+            continue;
+
+        // Both address spaces copy the page on their next write. A page left
+        // copy-on-write in src alone is made writable again on its next
+        // write.
+        *pte = (*pte & ~RW) | COW;
+        invlpg(virt);
+        get_physical_page((void *)(*pte & 0xFFFFF000));
+        if (__map_page(dst, virt, *pte & 0xFFFFF000, COW | US) < 0) {
+            put_physical_page((void *)(*pte & 0xFFFFF000));
+            return -ENOMEM;
+        }
+    }
+    return 0;
+}
+
+void free_user_zone(uint32_t *pdir, uint32_t virt_start, uint32_t virt_end)
+{
+    for (uint64_t virt = ALIGN(virt_start); virt < virt_end; virt += PAGE_SIZE) {
+        uint32_t  pde = pdir[virt >> 22];
+        uint32_t *pte;
+
+        if (!(pde & PRESENT)) {
+            // Nothing mapped up to the next page table
+            virt = LARGE_ALIGN(virt) + LARGE_PAGE_SIZE - PAGE_SIZE;
+            continue;
+        }
+
+        if (pde & LARGE) {
+            if (virt == LARGE_ALIGN(virt) &&
+                virt_end - virt >= LARGE_PAGE_SIZE) {
+                free_physical_page((void *)LARGE_ALIGN(pde), LARGE_PAGE_PAGES);
+                pdir[virt >> 22] = 0;
+                invlpg(virt);
+                virt += LARGE_PAGE_SIZE - PAGE_SIZE;
+                continue;
+            }
+            // Only part of the large page goes.
+            if (split_large_page(pdir, virt) < 0)
+                panic("can't allocate more pages");
+        }
+
+        pte = page_entry(pdir, virt);
+        if (!(*pte & PRESENT))
+            continue;
+        put_physical_page((void *)(*pte & 0xFFFFF000));
+        *pte = 0;
+        // Threads sharing the page directory may still run with it loaded.
+        invlpg(virt);
+    }
+}
+
+static void *__dir_alloc(unsigned long size)
+{
     // Page directories and page tables must be 4Kb aligned.
     // Conveniently, they are the same table as a page, so we can reuse the page allocator.
-    uint32_t *dir = (uint32_t *)alloc_physical_page(1);
+    return try_alloc_physical_page(size / PAGE_SIZE);
+}
+
+static void __dir_free(void *dir, unsigned long size)
+{
+    free_physical_page(dir, size / PAGE_SIZE);
+}
+
+static void __dir_ctor(void *obj)
+{
+    // Early page directory from early_mm.c
+    extern uint32_t pgdir[];
+    uint32_t       *dir = obj;
+
     memset(dir, 0, PAGE_SIZE);
 
-    // For the first 64 entries, the project has set up page tables for us,
+    // For the first KERNEL_PDES entries, the project has set up page tables for us,
     // in the pgdir[] variable. (in early_mm.c). Following the advice at
     // https://ensiwiki.ensimag.fr/index.php?title=Projet_syst%C3%A8me_:_Aspects_techniques#Pagination,
     // we copy them in our page directory.
-    for (int i = 0; i < 64; i++) {
+    for (int i = 0; i < KERNEL_PDES; i++) {
         dir[i] = pgdir[i];
     }
+}
 
-    return dir;
+// Freed page directories keep their kernel entries, and no user entry.
+static struct obj_cache dir_cache = OBJ_CACHE_INIT(
+    "page_directory", PAGE_SIZE, __dir_ctor, __dir_alloc, __dir_free);
+
+uint32_t *page_directory_create()
+{
+    return obj_cache_alloc(&dir_cache);
 }
 
 void page_directory_destroy(uint32_t *dir)
 {
-    // The 64 first entries are shared between page directories of all processes,
-    // so we must not free them explicitly.
-    // Instead, free the other entries if they exist.
-    for (int i = 64; i < 1024; i++) {
-        if (((uint32_t)dir[i] & PRESENT) == 1) {
+    // The KERNEL_PDES first entries are shared between page directories of all
+    // processes, so we must not free them explicitly.
+    // Instead, free the other entries if they exist. Large pages were freed
+    // with the zones holding them.
+    for (int i = KERNEL_PDES; i < 1024; i++) {
+        if (((uint32_t)dir[i] & (PRESENT | LARGE)) == PRESENT) {
             uint32_t page_table_address = dir[i] & 0xFFFFF000;
             free_physical_page((void *)page_table_address, 1);
+            dir[i] = 0;
         }
     }
 
-    free_physical_page((void *)dir, 1);
+    obj_cache_free(&dir_cache, dir);
+}
+
+/**
+ * Give the task its own copy of a copy-on-write page it writes to. If no
+ * other address space uses the page any more, it is simply made writable.
+ * @return 0 if the page is not copy-on-write, -ENOMEM if the page allocator
+ * is out of memory for the copy, 1 otherwise.
+ */
+static int copy_on_write(uint32_t *dir, uint32_t virt_addr)
+{
+    uint32_t *pte = page_entry(dir, virt_addr);
+    void     *page;
+    uint32_t *copy;
+
+    if (!pte || (*pte & (PRESENT | COW)) != (PRESENT | COW))
+        return 0;
+
+    page = (void *)(*pte & 0xFFFFF000);
+    if (physical_page_shared(page)) {
+        copy = try_alloc_physical_page(1);
+        if (!copy)
+            return -ENOMEM;
+        memcpy(copy, page, PAGE_SIZE);
+        put_physical_page(page);
+        page = copy;
+    }
+    *pte = (uint32_t)page | US | RW | PRESENT;
+    invlpg(virt_addr);
+    return 1;
+}
+
+void *user_page_private(uint32_t *dir, uint32_t virt_addr)
+{
+    uint32_t *pte = page_entry(dir, virt_addr);
+
+    // Large pages are never copy-on-write.
+    if (in_large_page(dir, virt_addr))
+        return (void *)(LARGE_ALIGN(dir[virt_addr >> 22]) +
+                        (ALIGN(virt_addr) & (LARGE_PAGE_SIZE - 1)));
+
+    if (!pte || !(*pte & PRESENT))
+        return NULL;
+
+    if (copy_on_write(dir, virt_addr) < 0)
+        return NULL;
+    return (void *)(*pte & 0xFFFFF000);
+}
+
+/**
+ * Slot of the stack reservation holding a virtual address, -1 if none.
+ */
+static int stack_slot(struct user_space *space, uint32_t virt_addr)
+{
+    uint32_t slot;
+
+    if (virt_addr >= USER_STACK_END)
+        return -1;
+
+    slot = (USER_STACK_END - 1 - virt_addr) / STACK_SLOT_SIZE;
+    if (slot >= MAX_THREADS || !space->stack_bottoms[slot])
+        return -1;
+    return slot;
+}
+
+/**
+ * Whether a virtual address is in one of the stacks of an address space.
+ */
+static bool in_stack(struct user_space *space, uint32_t virt_addr)
+{
+    int slot = stack_slot(space, virt_addr);
+
+    return slot >= 0 && virt_addr >= space->stack_bottoms[slot];
 }
 
-void page_fault_handler()
+/**
+ * Whether a virtual address is in the page below one of the stacks.
+ */
+static bool in_guard_page(struct user_space *space, uint32_t virt_addr)
 {
-    uint32_t addr;
+    int slot = stack_slot(space, virt_addr);
+
+    return slot >= 0 && virt_addr < space->stack_bottoms[slot] &&
+           virt_addr >= space->stack_bottoms[slot] - PAGE_SIZE;
+}
+
+/**
+ * Whether a virtual address is below the break of an address space.
+ */
+static bool in_heap(struct user_space *space, uint32_t virt_addr)
+{
+    return virt_addr >= space->heap_start && virt_addr < space->brk;
+}
+
+/**
+ * Back the stack or heap page holding virt_addr with a zeroed page.
+ * @return false if the page allocator is out of memory.
+ */
+static bool map_zero_page(struct user_space *space, uint32_t virt_addr)
+{
+    uint32_t *page = try_alloc_physical_page(1);
+
+    if (!page)
+        return false;
+    memset(page, 0, PAGE_SIZE);
+    if (__map_page(space->dir, ALIGN(virt_addr), (uint32_t)page, RW | US) < 0) {
+        free_physical_page(page, 1);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Back the whole aligned 4Mb holding virt_addr with a zeroed large page, if
+ * it is in [start, end), has no page table yet, and the page allocator can
+ * spare the memory (see LARGE_PAGE_RESERVE).
+ * @return false if the page is left to map_zero_page.
+ */
+static bool map_zero_large_page(struct user_space *space, uint32_t virt_addr,
+                                uint32_t start, uint32_t end)
+{
+    uint32_t  large = LARGE_ALIGN(virt_addr);
+    uint32_t *page;
+
+    if (large < start || end - large < LARGE_PAGE_SIZE)
+        return false;
+    if (space->dir[large >> 22] & PRESENT)
+        return false;
+    if (free_physical_pages() < LARGE_PAGE_PAGES + LARGE_PAGE_RESERVE)
+        return false;
+
+    page = try_alloc_physical_page(LARGE_PAGE_PAGES);
+    if (!page)
+        return false;
+    memset(page, 0, LARGE_PAGE_SIZE);
+    space->dir[large >> 22] = (uint32_t)page | LARGE | RW | US | PRESENT;
+    return true;
+}
+
+/**
+ * Area of an address space holding a virtual address, NULL if none.
+ */
+static struct vm_area *find_area(struct user_space *space, uint32_t virt_addr)
+{
+    struct vm_area *area;
+
+    queue_for_each(area, &space->areas, struct vm_area, areas)
+    {
+        if (virt_addr < area->start)
+            break;
+        if (virt_addr < area->end)
+            return area;
+    }
+    return NULL;
+}
+
+/**
+ * Back the page of an area holding virt_addr: with the page of its object
+ * for a shared area, allocated if nobody touched it yet, or with a zeroed
+ * page, large if possible.
+ * @return false if the page allocator is out of memory.
+ */
+static bool map_area_page(struct user_space *space, struct vm_area *area,
+                          uint32_t virt_addr)
+{
+    struct vm_object *object = area->object;
+    int               index;
+
+    if (!object)
+        return map_zero_large_page(space, virt_addr, area->start, area->end) ||
+               map_zero_page(space, virt_addr);
+
+    index = area->pgoff + (ALIGN(virt_addr) - area->start) / PAGE_SIZE;
+    if (!object->pages[index]) {
+        object->pages[index] = try_alloc_physical_page(1);
+        if (!object->pages[index])
+            return false;
+        memset(object->pages[index], 0, PAGE_SIZE);
+    }
+    get_physical_page(object->pages[index]);
+    if (__map_page(space->dir, ALIGN(virt_addr),
+                   (uint32_t)object->pages[index], RW | US) < 0) {
+        put_physical_page(object->pages[index]);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Object of a shared area of nb_pages pages, none of them allocated yet.
+ * @return NULL if out of memory.
+ */
+static struct vm_object *vm_object_create(int nb_pages)
+{
+    struct vm_object *object = mem_alloc(sizeof(struct vm_object));
+
+    if (!object)
+        return NULL;
+    object->nb_pages = nb_pages;
+    object->nb_users = 0;
+    object->pages    = mem_alloc(nb_pages * sizeof(uint32_t *));
+    if (!object->pages) {
+        mem_free(object, sizeof(struct vm_object));
+        return NULL;
+    }
+    memset(object->pages, 0, nb_pages * sizeof(uint32_t *));
+    return object;
+}
+
+static void vm_object_put(struct vm_object *object)
+{
+    if (--object->nb_users > 0)
+        return;
+
+    for (int i = 0; i < object->nb_pages; i++) {
+        if (object->pages[i])
+            put_physical_page(object->pages[i]);
+    }
+    mem_free(object->pages, object->nb_pages * sizeof(uint32_t *));
+    mem_free(object, sizeof(struct vm_object));
+}
+
+/**
+ * Area of [start, end), holding a reference on object if there is one.
+ * @return NULL if out of memory.
+ */
+static struct vm_area *area_create(uint32_t start, uint32_t end,
+                                   struct vm_object *object, int pgoff)
+{
+    struct vm_area *area = mem_alloc(sizeof(struct vm_area));
+
+    if (!area)
+        return NULL;
+    area->start  = start;
+    area->end    = end;
+    area->object = object;
+    area->pgoff  = pgoff;
+    INIT_LINK(&area->areas);
+    if (object)
+        object->nb_users++;
+    return area;
+}
+
+static void area_destroy(struct vm_area *area)
+{
+    if (area->object)
+        vm_object_put(area->object);
+    mem_free(area, sizeof(struct vm_area));
+}
+
+/**
+ * Give copy the areas of space: private pages are shared copy-on-write, and
+ * shared ones are found in their object on the next fault.
+ * @return -ENOMEM if out of memory, with the areas copied so far left in
+ * copy, 0 otherwise.
+ */
+static int clone_areas(struct user_space *copy, struct user_space *space)
+{
+    struct vm_area *area;
+    struct vm_area *area_copy;
+
+    queue_for_each(area, &space->areas, struct vm_area, areas)
+    {
+        area_copy = area_create(area->start, area->end, area->object,
+                                area->pgoff);
+        if (!area_copy)
+            return -ENOMEM;
+        queue_add_tail(area_copy, &copy->areas, areas);
+        if (!area->object &&
+            share_zone(copy->dir, space->dir, area->start, area->end) < 0)
+            return -ENOMEM;
+    }
+    return 0;
+}
+
+/**
+ * Unmap the pages of the areas in [start, end), and cut the areas to what
+ * is left of them.
+ * @return -ENOMEM if a hole in an area can't be made, with nothing unmapped,
+ * 0 otherwise.
+ */
+static int unmap_areas(struct user_space *space, uint32_t start, uint32_t end)
+{
+    struct vm_area *area;
+    struct vm_area *next;
+    struct vm_area *tail;
+
+    queue_for_each_safe(area, next, &space->areas, struct vm_area, areas)
+    {
+        uint32_t low  = area->start > start ? area->start : start;
+        uint32_t high = area->end < end ? area->end : end;
+
+        if (low >= high)
+            continue;
+
+        if (low > area->start && high < area->end) {
+            // A hole in the middle: the end becomes an area of its own. The
+            // hole is in this area only, so nothing is unmapped on failure.
+            tail = area_create(high, area->end, area->object,
+                               area->pgoff + (high - area->start) / PAGE_SIZE);
+            if (!tail)
+                return -ENOMEM;
+            free_user_zone(space->dir, low, high);
+            queue_add(tail, &space->areas, struct vm_area, areas, start);
+            area->end = low;
+            continue;
+        }
+
+        free_user_zone(space->dir, low, high);
+        if (low > area->start) {
+            area->end = low;
+        } else if (high < area->end) {
+            area->pgoff += (high - area->start) / PAGE_SIZE;
+            area->start = high;
+        } else {
+            queue_del(area, areas);
+            area_destroy(area);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Find a free zone of size bytes for a new area, first fit. Zones of at least
+ * a large page are aligned on one, so that they can be backed with large
+ * pages.
+ * @return its start, or 0 if there is no room left.
+ */
+static uint32_t find_free_zone(struct user_space *space, uint32_t size)
+{
+    struct vm_area *area;
+    uint64_t        addr  = USER_MMAP_START;
+    uint32_t        align = PAGE_SIZE;
+
+    if (size >= LARGE_PAGE_SIZE)
+        align = LARGE_PAGE_SIZE;
+
+    queue_for_each(area, &space->areas, struct vm_area, areas)
+    {
+        if (area->start >= addr && area->start - addr >= size)
+            break;
+        addr = (area->end + (uint64_t)align - 1) & ~(uint64_t)(align - 1);
+    }
+    if (addr > USER_MMAP_END || USER_MMAP_END - addr < size)
+        return 0;
+    return addr;
+}
+
+void *mmap(unsigned long length, int flags)
+{
+    struct user_space *space  = current()->space;
+    uint32_t           size   = ROUND_UP(length);
+    struct vm_object  *object = NULL;
+    struct vm_area    *area;
+    uint32_t           start;
+
+    if (!length || size < length)
+        return MAP_FAILED;
+    if (flags != MAP_PRIVATE && flags != MAP_SHARED)
+        return MAP_FAILED;
+
+    start = find_free_zone(space, size);
+    if (!start)
+        return MAP_FAILED;
+
+    if (flags == MAP_SHARED) {
+        object = vm_object_create(size / PAGE_SIZE);
+        if (!object)
+            return MAP_FAILED;
+    }
+
+    area = area_create(start, start + size, object, 0);
+    if (!area) {
+        if (object) {
+            mem_free(object->pages, object->nb_pages * sizeof(uint32_t *));
+            mem_free(object, sizeof(struct vm_object));
+        }
+        return MAP_FAILED;
+    }
+    queue_add(area, &space->areas, struct vm_area, areas, start);
+    return (void *)start;
+}
+
+int munmap(void *addr, unsigned long length)
+{
+    uint32_t start = (uint32_t)addr;
+    uint32_t end   = ROUND_UP(start + length);
+
+    if (start & (PAGE_SIZE - 1) || !length)
+        return -EINVAL;
+    if (start < USER_MMAP_START || end > USER_MMAP_END || end <= start)
+        return -EINVAL;
+
+    return unmap_areas(current()->space, start, end);
+}
+
+struct user_space *user_space_create(void)
+{
+    struct user_space *space = mem_alloc(sizeof(struct user_space));
+
+    if (!space)
+        return NULL;
+    space->dir = page_directory_create();
+    if (!space->dir) {
+        mem_free(space, sizeof(struct user_space));
+        return NULL;
+    }
+    space->nb_users      = 1;
+    space->code_pages    = NULL;
+    space->nb_code_pages = 0;
+    memset(space->stack_bottoms, 0, sizeof(space->stack_bottoms));
+    space->heap_start = 0;
+    space->brk        = 0;
+    INIT_LIST_HEAD(&space->areas);
+    return space;
+}
+
+struct user_space *user_space_clone(struct user_space *space, int slot)
+{
+    struct user_space *copy = user_space_create();
+
+    if (!copy)
+        return NULL;
+    copy->code_pages          = space->code_pages;
+    copy->nb_code_pages       = space->nb_code_pages;
+    copy->stack_bottoms[slot] = space->stack_bottoms[slot];
+    copy->heap_start          = space->heap_start;
+    copy->brk                 = space->brk;
+    // On failure, the pages shared so far are dropped with the copy.
+    if (share_zone(copy->dir, space->dir, USER_START,
+                   USER_START + space->nb_code_pages * PAGE_SIZE) < 0 ||
+        share_zone(copy->dir, space->dir, space->heap_start,
+                   ROUND_UP(space->brk)) < 0 ||
+        share_zone(copy->dir, space->dir, space->stack_bottoms[slot],
+                   STACK_SLOT_TOP(slot)) < 0 ||
+        clone_areas(copy, space) < 0) {
+        user_space_put(copy);
+        return NULL;
+    }
+    return copy;
+}
+
+void user_space_get(struct user_space *space)
+{
+    space->nb_users++;
+}
+
+void user_space_put(struct user_space *space)
+{
+    if (--space->nb_users > 0)
+        return;
+
+    // Pages shared with the app image or other processes are only freed
+    // with their last reference.
+    free_user_zone(space->dir, USER_START,
+                   USER_START + space->nb_code_pages * PAGE_SIZE);
+    free_user_zone(space->dir, space->heap_start, ROUND_UP(space->brk));
+    unmap_areas(space, USER_MMAP_START, USER_MMAP_END);
+    for (int slot = 0; slot < MAX_THREADS; slot++) {
+        if (space->stack_bottoms[slot])
+            user_stack_destroy(space, slot);
+    }
+    page_directory_destroy(space->dir);
+    mem_free(space, sizeof(struct user_space));
+}
+
+int user_stack_create(struct user_space *space, uint32_t size,
+                      uint32_t **top_page)
+{
+    for (int slot = 0; slot < MAX_THREADS; slot++) {
+        uint32_t top = STACK_SLOT_TOP(slot);
+
+        if (space->stack_bottoms[slot])
+            continue;
+
+        // The page below the stack is left unmapped as a guard.
+        *top_page = try_alloc_physical_page(1);
+        if (!*top_page)
+            return -1;
+        memset(*top_page, 0, PAGE_SIZE);
+        if (__map_page(space->dir, top - PAGE_SIZE, (uint32_t)*top_page,
+                       RW | US) < 0) {
+            free_physical_page(*top_page, 1);
+            return -1;
+        }
+        user_stack_resize(space, slot, size);
+        return slot;
+    }
+    return -1;
+}
+
+void user_stack_resize(struct user_space *space, int slot, uint32_t size)
+{
+    space->stack_bottoms[slot] = ALIGN(STACK_SLOT_TOP(slot) - size);
+}
+
+void user_stack_destroy(struct user_space *space, int slot)
+{
+    free_user_zone(space->dir, space->stack_bottoms[slot],
+                   STACK_SLOT_TOP(slot));
+    space->stack_bottoms[slot] = 0;
+}
+
+void *sys_sbrk(long increment)
+{
+    struct user_space *space   = current()->space;
+    uint32_t           old_brk = space->brk;
+    uint32_t           new_brk = old_brk + increment;
+
+    if (increment > 0 && (new_brk < old_brk || new_brk > USER_HEAP_END))
+        return (void *)-1;
+    if (increment < 0 && (new_brk > old_brk || new_brk < space->heap_start))
+        return (void *)-1;
+
+    // Pages above the new break are given back.
+    if (increment < 0)
+        free_user_zone(space->dir, ROUND_UP(new_brk), ROUND_UP(old_brk));
+    space->brk = new_brk;
+    return (void *)old_brk;
+}
+
+void page_fault_handler(uint32_t error_code)
+{
+    uint32_t        addr;
+    struct task    *self = current();
+    struct vm_area *area;
+    const char     *what = "Segmentation fault";
+    int             cow  = 0;
     __asm__("mov %%cr2, %0" : "=r"(addr));
 
+    if ((error_code & (PF_PRESENT | PF_WRITE)) == (PF_PRESENT | PF_WRITE))
+        cow = copy_on_write(self->space->dir, addr);
+
+    if (cow > 0) {
+        return;
+    } else if (cow < 0) {
+        what = "Out of memory";
+    } else if (!(error_code & PF_PRESENT) && in_stack(self->space, addr)) {
+        if (map_zero_page(self->space, addr))
+            return;
+        what = "Out of memory";
+    } else if (!(error_code & PF_PRESENT) && in_heap(self->space, addr)) {
+        if (map_zero_large_page(self->space, addr, self->space->heap_start,
+                                self->space->brk) ||
+            map_zero_page(self->space, addr))
+            return;
+        what = "Out of memory";
+    } else if (!(error_code & PF_PRESENT) &&
+               (area = find_area(self->space, addr))) {
+        if (map_area_page(self->space, area, addr))
+            return;
+        what = "Out of memory";
+    } else if (in_guard_page(self->space, addr)) {
+        what = "Stack overflow";
+    }
+
     char str[100];
-    int  size = sprintf(str, "[%s] Segmentation fault at: 0x%08X\n",
-                        current()->comm, addr);
+    int  size = sprintf(str, "[%s] %s at: 0x%08X\n", self->comm, what, addr);
     change_color(RED_FG);
     console_putbytes(str, size);
     change_color(DEFAULT);
@@ -182,19 +918,28 @@ void page_fault_handler()
 
 void init_page_fault_handler()
 {
+    uint32_t cr0;
+
     register_interrupt_handler(14, page_fault_isr);
+
+    __asm__ __volatile__("movl %%cr0, %0" : "=r"(cr0));
+    __asm__ __volatile__("movl %0, %%cr0" ::"r"(cr0 | CR0_WP));
 }
 
 bool is_user_addr(uint32_t *dir, uint32_t virt_addr)
 {
-    uint32_t pd_index = virt_addr >> 22;
-    uint32_t pt_index = (virt_addr >> 12) & 0x3FF;
-
-    if (((uint32_t)dir[pd_index] & PRESENT) == 0) {
-        return false;
-    }
+    uint32_t *pte = page_entry(dir, virt_addr);
 
-    uint32_t *page_table = (uint32_t *)(dir[pd_index] & 0xFFFFF000);
     // Is the page user mapped?
-    return page_table[pt_index] & US;
+    if (pte && (*pte & US))
+        return true;
+    if (in_large_page(dir, virt_addr) && (dir[virt_addr >> 22] & US))
+        return true;
+
+    // Stack and heap pages not touched yet are mapped when the kernel
+    // accesses them.
+    return dir == current()->space->dir &&
+           (in_stack(current()->space, virt_addr) ||
+            in_heap(current()->space, virt_addr) ||
+            find_area(current()->space, virt_addr));
 }
\ No newline at end of file
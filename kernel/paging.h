@@ -3,6 +3,7 @@
 
 #include "stdint.h"
 #include "stdbool.h"
+#include "queue.h"
 
 // A page is 4Kb (0x1000)
 #define PAGE_SIZE 0x1000
@@ -16,6 +17,84 @@
 #define RW 0x2
 // Page accessible in user mode if true, otherwhise only kernel mode page
 #define US 0x4
+// Read-only page shared with other address spaces, copied on the first
+// write (bit 9 is left to the OS by the processor)
+#define COW 0x200
+// Page directory entry mapping a 4Mb page instead of a page table (PSE)
+#define LARGE 0x80
+
+// A large page is 4Mb, the memory of a page table
+#define LARGE_PAGE_SIZE 0x400000
+#define LARGE_PAGE_PAGES (LARGE_PAGE_SIZE / PAGE_SIZE)
+
+// Entries of the kernel identity map, shared by all page directories: the
+// first 1GB, below user space, mostly with large pages (see early_mm.c)
+#define KERNEL_PDES 256
+
+// Most threads sharing an address space, each has its own stack slot
+#define MAX_THREADS 32
+
+/**
+ * Pages of a shared mapping, found by the page fault handler of every
+ * address space mapping it: a page is allocated on the first touch in any of
+ * them. The object holds the allocator reference of its pages, and each
+ * mapping of a page one more.
+ */
+struct vm_object {
+    uint32_t **pages;
+    int        nb_pages;
+    // Areas using this object
+    int        nb_users;
+};
+
+/**
+ * Zone of an address space made by mmap, backed on first touch.
+ */
+struct vm_area {
+    uint32_t          start;
+    uint32_t          end;
+    // Pages of a shared area, NULL for a private one: its pages are zeroed
+    // and copied on fork.
+    struct vm_object *object;
+    // Index in object of the page at start
+    int               pgoff;
+    link              areas;
+};
+
+/**
+ * User address space, shared by the threads of a process.
+ *
+ * Private memory (the heap and private mmap areas) is backed with large
+ * pages: the first touch in an aligned 4Mb that lies whole in the heap or in
+ * an area backs all of it, if the page allocator has a large page to spare.
+ * A large page is split into pages of 4Kb when it is shared copy-on-write by
+ * fork, or partly unmapped.
+ */
+struct user_space {
+    uint32_t *dir;
+    // Tasks using this address space
+    int       nb_users;
+    // Pages of the app image mapped at USER_START
+    uint32_t **code_pages;
+    int        nb_code_pages;
+    // Lowest address of the stack in each slot, 0 if the slot is free.
+    // Stack pages are allocated on first touch.
+    uint32_t  stack_bottoms[MAX_THREADS];
+    // Heap, from the end of the code up to the break (see sys_sbrk).
+    // Heap pages are allocated on first touch.
+    uint32_t  heap_start;
+    uint32_t  brk;
+    // Zones made by mmap, sorted by address
+    link      areas;
+};
+
+/**
+ * Map a page of virtual addresses to a page of physical addresses.
+ * @param dir The page directory to map on
+ * @param flags Flags to set on the page
+ */
+void map_page(uint32_t *dir, uint32_t virt_addr, uint32_t phy_addr,
+              uint32_t flags);
 
 /**
  * Map a zone of virtual adresses to a zone of physical adresses.
@@ -32,7 +111,90 @@ void map_zone(uint32_t *pdir, uint64_t virt_start, uint64_t virt_end,
  */
 void unmap_zone(uint32_t *pdir, uint64_t virt_start, uint64_t virt_end);
 
-/** Create a page directory. */
+/**
+ * Map nb_pages physical pages copy-on-write, taking a reference to each.
+ * The pages need not be contiguous: pages[i] is mapped at the i-th page
+ * from virt_start.
+ * @return -ENOMEM if out of memory, with the pages mapped so far left in
+ * place, 0 otherwise.
+ */
+int map_cow_pages(uint32_t *pdir, uint32_t virt_start, uint32_t **pages,
+                  int nb_pages);
+
+/**
+ * Map the pages of a zone of src in dst too, both copy-on-write.
+ * @pre src is the current page directory, or no task runs in it.
+ * @return -ENOMEM if out of memory, with part of the zone shared, 0
+ * otherwise.
+ */
+int share_zone(uint32_t *dst, uint32_t *src, uint32_t virt_start,
+               uint32_t virt_end);
+
+/**
+ * Unmap a zone, dropping the reference of the page directory to each page:
+ * a page is freed with its last reference.
+ */
+void free_user_zone(uint32_t *pdir, uint32_t virt_start, uint32_t virt_end);
+
+/**
+ * Create an address space used by one task, with no pages mapped.
+ * @return NULL if out of memory.
+ */
+struct user_space *user_space_create(void);
+
+/**
+ * Create an address space mapping the code of space and the stack of one of
+ * its slots, copy-on-write.
+ * @pre space is the current address space, or no task runs in it.
+ * @return NULL if out of memory.
+ */
+struct user_space *user_space_clone(struct user_space *space, int slot);
+
+/** Add a task to the users of an address space. */
+void user_space_get(struct user_space *space);
+
+/**
+ * Remove a task from the users of an address space, and free it with the
+ * last one.
+ */
+void user_space_put(struct user_space *space);
+
+/**
+ * Reserve a stack of size bytes in a free slot of an address space, and
+ * back its top page.
+ * @param top_page Set to the top page of the stack
+ * @return the slot, or -1 if all slots are used or there is no memory left.
+ */
+int user_stack_create(struct user_space *space, uint32_t size,
+                      uint32_t **top_page);
+
+/**
+ * Change the size reserved for the stack of a slot.
+ * @pre the pages below the new bottom of the stack are not backed.
+ */
+void user_stack_resize(struct user_space *space, int slot, uint32_t size);
+
+/** Free the pages of the stack of a slot, and the slot. */
+void user_stack_destroy(struct user_space *space, int slot);
+
+/**
+ * Move the break of the calling process by increment bytes. Pages of the
+ * heap are backed when first touched, and freed when the break goes below
+ * them.
+ * @return the previous break, or (void *)-1 if the heap would go out of its
+ * zone.
+ */
+void *sys_sbrk(long increment);
+
+/**
+ * Get the physical page mapped at a user address, so that the kernel can
+ * write to it for a task: a copy-on-write page is copied first.
+ * @return NULL if nothing is mapped there, or if there is no memory left
+ * for the copy.
+ */
+void *user_page_private(uint32_t *dir, uint32_t virt_addr);
+
+/** Create a page directory, NULL if out of memory. */
 uint32_t *page_directory_create();
 
 /**
@@ -41,12 +203,20 @@ uint32_t *page_directory_create();
  */
 void page_directory_destroy(uint32_t *dir);
 
-void page_fault_handler();
-/** Init the page fault handler, which will kill a process if it does a page fault. */
+/**
+ * Resolve a page fault, or kill the process that did it.
+ * @param error_code Pushed by the processor: present, write and user bits.
+ */
+void page_fault_handler(uint32_t error_code);
+/**
+ * Init the page fault handler, which copies pages on write, allocates stack
+ * pages on first touch and kills a process for any other page fault.
+ */
 void init_page_fault_handler();
 
 /**
- * Check if an virtual address is mapped with user privileges.
+ * Check if an virtual address is mapped with user privileges, or will be
+ * on first touch.
  * @param dir
  * @param virt_addr
  * @return Whether the address is mapped as user
@@ -2,6 +2,10 @@
 #define __PARAMETERS_H__
 
 #define CLOCK_FREQUENCY 50
+// Stop the periodic tick while the idle task runs (see clock_idle_enter)
+#define TICKLESS_IDLE
+// Record task state changes and ready queue latencies (see sched_trace.c)
+#define SCHED_TRACE
 
 #define MIN_PRIO 1
 #define MAX_PRIO 256
@@ -11,9 +15,18 @@
 #define KSTACK_SZ 1024
 #define USTACK_SZ_MAX 8192
 
-#define NBPROC 32
-#define PID_MAX NBPROC - 1
+// Number of pids: the pid table only grows with the tasks alive at once
+#define NBPROC 32768
+#define PID_MAX (NBPROC - 1)
 #define PID_MIN 0 // SHOULD NOT BE CHANGED
 #define BUDDY_ALLOCATOR
+// Time the page allocator under random allocs and frees at boot
+// (see page_alloc_bench.c)
+// #define PAGE_ALLOC_BENCH
+// Number of freed objects kept ready for reuse by an object cache
+#define OBJ_CACHE_SIZE 64
+// Free pages left to the page allocator when backing user memory with
+// large pages: below this, user memory gets 4Kb pages (see paging.h)
+#define LARGE_PAGE_RESERVE 0x2000
 
 #endif
\ No newline at end of file
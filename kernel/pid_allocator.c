@@ -1,39 +1,109 @@
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "pid_allocator.h"
+#include "cpu.h"
+#include "mem.h"
+
+/*
+ * Pids are allocated from a bitmap. A summary bitmap has one bit per bitmap
+ * word, set when the word is full: finding the lowest free pid takes the
+ * first zero bit of a summary word, then the first zero bit of the bitmap
+ * word it points to.
+ *
+ * Tasks are found from their pid in a two-level table: a directory of
+ * chunks of PID_CHUNK_SIZE task pointers. A chunk is allocated the first
+ * time one of its pids is used, so the table only grows with the number of
+ * tasks alive at once.
+ */
+
+#define PID_COUNT (PID_MAX + 1)
 
 // word is 32 bits
 #define WORD_OFFSET(b) ((b) / 32)
 #define BIT_OFFSET(b) ((b) % 32)
+#define FULL_WORD 0xFFFFFFFFu
+
+#define PIDMAP_WORDS ((PID_COUNT + 31) / 32)
+#define SUMMARY_WORDS ((PIDMAP_WORDS + 31) / 32)
 
-/* bitmap */
-uint32_t __pidmap[PID_MAX % 8 == 0 ? PID_MAX / 8 : PID_MAX / 8 + 1] = { 0 };
+#define PID_CHUNK_SIZE 256
+#define PID_CHUNKS ((PID_COUNT + PID_CHUNK_SIZE - 1) / PID_CHUNK_SIZE)
+
+/* bitmaps */
+static uint32_t __pidmap[PIDMAP_WORDS]       = { 0 };
+static uint32_t __pidmap_full[SUMMARY_WORDS] = { 0 };
+
+/* pid -> task table */
+static struct task **__pid_chunks[PID_CHUNKS] = { NULL };
 
 static void set_pid(pid_t pid)
 {
-    __pidmap[WORD_OFFSET(pid)] |= (1 << BIT_OFFSET(pid));
+    int word = WORD_OFFSET(pid);
+
+    __pidmap[word] |= (1u << BIT_OFFSET(pid));
+    if (__pidmap[word] == FULL_WORD)
+        __pidmap_full[WORD_OFFSET(word)] |= (1u << BIT_OFFSET(word));
 }
 
 void free_pid(pid_t pid)
 {
-    __pidmap[WORD_OFFSET(pid)] &= ~(1 << BIT_OFFSET(pid));
+    int word = WORD_OFFSET(pid);
+
+    __pidmap[word] &= ~(1u << BIT_OFFSET(pid));
+    __pidmap_full[WORD_OFFSET(word)] &= ~(1u << BIT_OFFSET(word));
 }
 
-static bool pid_used(pid_t pid)
+static pid_t find_free_pid(void)
 {
-    return __pidmap[WORD_OFFSET(pid)] & (1 << BIT_OFFSET(pid));
+    for (int i = 0; i < SUMMARY_WORDS; i++) {
+        if (__pidmap_full[i] == FULL_WORD)
+            continue;
+
+        int word = i * 32 + bsf(~__pidmap_full[i]);
+        if (word >= PIDMAP_WORDS)
+            return -1;
+
+        pid_t pid = word * 32 + bsf(~__pidmap[word]);
+        return pid <= PID_MAX ? pid : -1;
+    }
+    return -1;
 }
 
 pid_t alloc_pid(void)
 {
-    pid_t pid = 0;
-    for (; pid_used(pid); pid++) {
-        if (pid > PID_MAX) {
+    pid_t          pid = find_free_pid();
+    struct task ***chunk;
+
+    if (pid < 0)
+        return -1;
+
+    // Make sure pid_set_task() cannot fail for this pid.
+    chunk = &__pid_chunks[pid / PID_CHUNK_SIZE];
+    if (!*chunk) {
+        *chunk = mem_alloc(PID_CHUNK_SIZE * sizeof(struct task *));
+        if (!*chunk)
             return -1;
-        }
+        memset(*chunk, 0, PID_CHUNK_SIZE * sizeof(struct task *));
     }
     set_pid(pid);
 
     return pid;
-}
\ No newline at end of file
+}
+
+void pid_set_task(pid_t pid, struct task *task_ptr)
+{
+    __pid_chunks[pid / PID_CHUNK_SIZE][pid % PID_CHUNK_SIZE] = task_ptr;
+}
+
+struct task *pid_get_task(pid_t pid)
+{
+    struct task **chunk;
+
+    if (pid < PID_MIN || pid > PID_MAX)
+        return NULL;
+
+    chunk = __pid_chunks[pid / PID_CHUNK_SIZE];
+    return chunk ? chunk[pid % PID_CHUNK_SIZE] : NULL;
+}
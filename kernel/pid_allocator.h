@@ -4,6 +4,8 @@
 #include "parameters.h"
 #include "types.h"
 
+struct task;
+
 /**
  * Allocates a pid.
  * @return -1 if there is no free pid left, the pid otherwise
@@ -13,5 +15,14 @@ pid_t alloc_pid(void);
  * Free a pid: it can be used by another process.
  */
 void free_pid(pid_t pid);
+/**
+ * Record the task using an allocated pid, or NULL once it is gone.
+ */
+void pid_set_task(pid_t pid, struct task *task_ptr);
+/**
+ * Find a task from its pid, in constant time.
+ * @return NULL if no task was recorded for this pid.
+ */
+struct task *pid_get_task(pid_t pid);
 
 #endif
\ No newline at end of file
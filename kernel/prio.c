@@ -3,6 +3,8 @@
 #include "errno.h"
 #include "cpu.h"
 #include "msg.h"
+#include "primitive.h"
+#include "paging.h"
 
 int getprio(int pid)
 {
@@ -15,6 +17,24 @@ int getprio(int pid)
     return task_ptr->priority;
 }
 
+/**
+ * Give the CPU to task_ptr, or take it away from it, after a change of its
+ * priority or scheduling class.
+ */
+static void __preempt_if_outranked(struct task *task_ptr)
+{
+    if (!is_current(task_ptr) && is_task_ready(task_ptr) &&
+        task_outranks(task_ptr, current())) {
+        schedule();
+    }
+    if (is_current(task_ptr)) {
+        struct task *highest_prio_ready = ready_queue_top();
+        if (highest_prio_ready && task_outranks(highest_prio_ready, task_ptr)) {
+            schedule();
+        }
+    }
+}
+
 static void __update_queue_priority(struct task *task_ptr)
 {
     struct list_link *queue_head;
@@ -44,30 +64,98 @@ int chprio(int pid, int priority)
     if (priority > MAX_PRIO || priority < MIN_PRIO)
         return -EINVAL;
 
-    old_priority = task_ptr->priority;
-    set_task_priority(task_ptr, priority);
+    old_priority = task_ptr->base_priority;
+    task_ptr->base_priority = priority;
+    // Tasks blocked on a message queue may still lend a higher priority.
+    set_task_priority(task_ptr, msg_inherited_priority(task_ptr));
     __update_queue_priority(task_ptr);
 
     if (is_task_interrupted_msg(task_ptr)) {
         // Need to update the task position in msg queue as well, since its prio changed
         msg_reinsert(task_ptr);
-        // Because this task is blocked on msg, it cannot be scheduled to
+        // Because this task is blocked on msg, it cannot be scheduled to, but
+        // the task it waits for may inherit its new priority.
+        msg_priority_changed(task_ptr);
+        __preempt_if_outranked(current());
         return old_priority;
     }
 
-    if (!is_current(task_ptr) && is_task_ready(task_ptr) &&
-        task_ptr->priority > current()->priority) {
-        schedule();
-    }
-    if (is_current(task_ptr)) {
-        struct task *highest_prio_ready =
-            queue_top(&tasks_ready_queue, struct task, tasks);
-        //        printf("highest prio ready:%d\n", highest_prio_ready->priority);
-        //        global_list_debug();
-        if (highest_prio_ready->priority > priority) {
-            schedule();
-        }
-    }
+    __preempt_if_outranked(task_ptr);
 
     return old_priority;
+}
+
+int sched_setclass(int pid, int sched_class, int weight)
+{
+    struct task *task_ptr;
+
+    task_ptr = pid_to_task(pid);
+    if (!task_ptr)
+        return -ESRCH;
+
+    if (is_idle(task_ptr))
+        return -EINVAL;
+
+    if (is_task_zombie(task_ptr))
+        return -ESRCH;
+
+    if (sched_class == SCHED_RR) {
+        weight = FAIR_DEFAULT_WEIGHT;
+    } else if (sched_class != SCHED_FAIR || weight < 1 ||
+               weight > FAIR_MAX_WEIGHT) {
+        return -EINVAL;
+    }
+
+    set_task_sched_class(task_ptr, sched_class, weight);
+    __preempt_if_outranked(task_ptr);
+    return 0;
+}
+
+int sched_setdeadline(int pid, unsigned long runtime, unsigned long deadline,
+                      unsigned long period)
+{
+    struct task *task_ptr;
+    int          ret;
+
+    task_ptr = pid_to_task(pid);
+    if (!task_ptr)
+        return -ESRCH;
+
+    if (is_idle(task_ptr))
+        return -EINVAL;
+
+    if (is_task_zombie(task_ptr))
+        return -ESRCH;
+
+    if (runtime == 0 || runtime > deadline || deadline > period ||
+        period > UINT32_MAX / 2)
+        return -EINVAL;
+
+    ret = set_task_deadline(task_ptr, runtime, deadline, period);
+    if (ret < 0)
+        return ret;
+
+    __preempt_if_outranked(task_ptr);
+    return 0;
+}
+
+int sched_getdlstats(int pid, struct sched_dl_stats *stats)
+{
+    struct task *task_ptr;
+    uint32_t    *dir = (uint32_t *)current()->regs[CR3];
+
+    // Both ends of the structure must be writable by the caller.
+    if (!is_user_addr(dir, (uint32_t)stats) ||
+        !is_user_addr(dir, (uint32_t)(stats + 1) - 1))
+        return -EINVAL;
+
+    task_ptr = pid_to_task(pid);
+    if (!task_ptr || is_task_zombie(task_ptr))
+        return -ESRCH;
+
+    if (task_ptr->sched_class != SCHED_DEADLINE)
+        return -EINVAL;
+
+    *stats = task_ptr->dl_stats;
+    return 0;
 }
\ No newline at end of file
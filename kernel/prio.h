@@ -1,7 +1,13 @@
 #ifndef __PRIO_H__
 #define __PRIO_H__
 
+struct sched_dl_stats;
+
 int getprio(int pid);
 int chprio(int pid, int priority);
+int sched_setclass(int pid, int sched_class, int weight);
+int sched_setdeadline(int pid, unsigned long runtime, unsigned long deadline,
+                      unsigned long period);
+int sched_getdlstats(int pid, struct sched_dl_stats *stats);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,144 @@
+/**
+ * CPU bandwidth groups.
+ *
+ * A task and the children it starts afterwards share a CPU quota per
+ * period. Each tick is charged to the group of the running task, see
+ * schedule_tick(). Once the group used up its quota, schedule() parks its
+ * tasks on the group throttled list instead of running them, whatever
+ * their priority. A timer puts them back in the ready queue when the next
+ * period starts.
+ *
+ * Periods are only tracked while the group runs: a group idle for several
+ * periods starts a new period when it runs again.
+ */
+
+#include "sched_group.h"
+#include "task.h"
+#include "clock.h"
+#include "mem.h"
+#include "errno.h"
+
+static void sched_group_refill(void *data)
+{
+    struct sched_group *group = data;
+    uint32_t            now   = current_clock();
+
+    timer_del(&group->refill_timer);
+    group->period_start = now - (now - group->period_start) % group->period;
+    group->used         = 0;
+
+    while (!queue_empty(&group->throttled)) {
+        set_task_ready(queue_entry(group->throttled.next, struct task, tasks));
+    }
+}
+
+static void sched_group_update(struct sched_group *group)
+{
+    if (current_clock() - group->period_start >= group->period)
+        sched_group_refill(group);
+}
+
+static struct sched_group *sched_group_alloc(uint32_t quota, uint32_t period)
+{
+    struct sched_group *group = mem_alloc(sizeof(struct sched_group));
+    if (!group)
+        return NULL;
+
+    group->quota        = quota;
+    group->period       = period;
+    group->period_start = current_clock();
+    group->used         = 0;
+    group->nr_tasks     = 0;
+    INIT_LIST_HEAD(&group->throttled);
+    timer_init(&group->refill_timer, sched_group_refill, group);
+    return group;
+}
+
+void sched_group_join(struct task *task_ptr, struct sched_group *group)
+{
+    task_ptr->group = group;
+    group->nr_tasks++;
+}
+
+void sched_group_leave(struct task *task_ptr)
+{
+    struct sched_group *group = task_ptr->group;
+
+    if (!group)
+        return;
+
+    // Do not leave the task on the throttled list of a group it left.
+    if (is_task_throttled(task_ptr) && !IS_LINK_NULL(&task_ptr->tasks))
+        set_task_ready(task_ptr);
+
+    task_ptr->group = NULL;
+    if (--group->nr_tasks == 0) {
+        timer_del(&group->refill_timer);
+        mem_free(group, sizeof(struct sched_group));
+    }
+}
+
+bool sched_group_charge(struct task *task_ptr)
+{
+    struct sched_group *group = task_ptr->group;
+
+    if (!group)
+        return false;
+
+    sched_group_update(group);
+    group->used++;
+    return group->used >= group->quota;
+}
+
+bool sched_group_throttled(struct task *task_ptr)
+{
+    struct sched_group *group = task_ptr->group;
+
+    if (!group)
+        return false;
+
+    sched_group_update(group);
+    return group->used >= group->quota;
+}
+
+void sched_group_park(struct task *task_ptr)
+{
+    struct sched_group *group = task_ptr->group;
+
+    set_task_throttled(task_ptr);
+    queue_add_tail(task_ptr, &group->throttled, tasks);
+    if (!timer_pending(&group->refill_timer))
+        timer_add(&group->refill_timer, group->period_start + group->period);
+}
+
+int sched_setquota(int pid, unsigned long quota, unsigned long period)
+{
+    struct task        *task_ptr;
+    struct sched_group *group;
+
+    task_ptr = pid_to_task(pid);
+    if (!task_ptr)
+        return -ESRCH;
+
+    if (is_idle(task_ptr))
+        return -EINVAL;
+
+    if (is_task_zombie(task_ptr))
+        return -ESRCH;
+
+    if (quota == 0) {
+        sched_group_leave(task_ptr);
+        return 0;
+    }
+
+    if (period == 0 || quota > period || period > UINT32_MAX / 2)
+        return -EINVAL;
+
+    group = sched_group_alloc(quota, period);
+    if (!group)
+        return -ENOMEM;
+
+    sched_group_leave(task_ptr);
+    sched_group_join(task_ptr, group);
+    return 0;
+}
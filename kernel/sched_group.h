@@ -0,0 +1,61 @@
+#ifndef __SCHED_GROUP_H__
+#define __SCHED_GROUP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "queue.h"
+#include "timer.h"
+
+struct task;
+
+/**
+ * A group of tasks sharing a CPU quota: together, they may run quota ticks
+ * per period ticks. Once the quota is used up, the tasks of the group are
+ * throttled until the next period.
+ */
+struct sched_group {
+    uint32_t quota;
+    uint32_t period;
+    // Clock tick at which the current period started
+    uint32_t period_start;
+    // Ticks used by the group in the current period
+    uint32_t used;
+    // Number of living tasks in the group
+    int      nr_tasks;
+    // Throttled tasks, waiting for the next period
+    struct list_link throttled;
+    // Refills the quota at the end of the period, when tasks are throttled
+    struct timer     refill_timer;
+};
+
+/**
+ * Add a task to a group. The task must not be in a group.
+ */
+void sched_group_join(struct task *task_ptr, struct sched_group *group);
+
+/**
+ * Remove a task from its group, if it has one. The group is freed with its
+ * last task.
+ */
+void sched_group_leave(struct task *task_ptr);
+
+/**
+ * Account a clock tick to the group of the running task.
+ * @return true if the group used up its quota for this period.
+ */
+bool sched_group_charge(struct task *task_ptr);
+
+/**
+ * Whether the group of the task used up its quota for this period.
+ */
+bool sched_group_throttled(struct task *task_ptr);
+
+/**
+ * Throttle a task of a group out of quota, until the next period.
+ */
+void sched_group_park(struct task *task_ptr);
+
+/* see primitive.h for doc */
+int sched_setquota(int pid, unsigned long quota, unsigned long period);
+
+#endif //__SCHED_GROUP_H__
@@ -0,0 +1,95 @@
+/**
+ * Scheduler tracing.
+ *
+ * Every state change of a task is recorded with its rdtsc timestamp in a
+ * ring buffer of TRACE_SIZE events: the oldest events are overwritten.
+ *
+ * The time a task waits between being set ready and running is also added
+ * to a histogram per priority. Bucket i counts the waits of 2^i to
+ * 2^(i+1) - 1 cycles, the last bucket all longer waits.
+ */
+
+#include <string.h>
+#include "sched_trace.h"
+#include "task.h"
+#include "cpu.h"
+#include "errno.h"
+#include "paging.h"
+#include "primitive.h"
+
+#define TRACE_SIZE 256
+
+static struct sched_trace_event trace_ring[TRACE_SIZE];
+// Number of events recorded since boot, the next one goes to
+// trace_ring[trace_count % TRACE_SIZE]
+static uint32_t trace_count = 0;
+
+static unsigned long latency_hist[MAX_PRIO + 1][SCHED_LATENCY_BUCKETS];
+
+#ifdef SCHED_TRACE
+void trace_task_state(struct task *task_ptr)
+{
+    struct sched_trace_event *event = &trace_ring[trace_count % TRACE_SIZE];
+
+    event->tsc   = rdtsc();
+    event->pid   = task_ptr->pid;
+    event->prio  = task_ptr->priority;
+    event->state = task_ptr->state;
+    trace_count++;
+}
+
+void trace_ready_latency(struct task *task_ptr, uint64_t latency)
+{
+    int bucket = SCHED_LATENCY_BUCKETS - 1;
+
+    if (latency >> 32 == 0)
+        bucket = bsr((uint32_t)latency | 1);
+
+    latency_hist[task_ptr->priority][bucket]++;
+}
+#endif
+
+static bool is_user_zone(const void *start, uint32_t size)
+{
+    uint32_t *dir = (uint32_t *)current()->regs[CR3];
+
+    return size > 0 && is_user_addr(dir, (uint32_t)start) &&
+           is_user_addr(dir, (uint32_t)start + size - 1);
+}
+
+int sched_trace(struct sched_trace_event *events, int count)
+{
+    uint32_t first;
+
+    if (count <= 0 || !is_user_zone(events, count * sizeof(*events)))
+        return -EINVAL;
+
+    if ((uint32_t)count > TRACE_SIZE)
+        count = TRACE_SIZE;
+    if ((uint32_t)count > trace_count)
+        count = trace_count;
+
+    // Oldest first
+    first = trace_count - count;
+    for (int i = 0; i < count; i++) {
+        events[i] = trace_ring[(first + i) % TRACE_SIZE];
+    }
+    return count;
+}
+
+int sched_latency(int prio, unsigned long *buckets)
+{
+    unsigned long samples = 0;
+
+    if (prio < MIN_PRIO || prio > MAX_PRIO)
+        return -EINVAL;
+
+    if (!is_user_zone(buckets, SCHED_LATENCY_BUCKETS * sizeof(*buckets)))
+        return -EINVAL;
+
+    memcpy(buckets, latency_hist[prio], sizeof(latency_hist[prio]));
+    for (int i = 0; i < SCHED_LATENCY_BUCKETS; i++) {
+        samples += buckets[i];
+    }
+    return samples;
+}
@@ -0,0 +1,39 @@
+#ifndef __SCHED_TRACE_H__
+#define __SCHED_TRACE_H__
+
+#include <stdint.h>
+#include "parameters.h"
+
+struct task;
+struct sched_trace_event;
+
+#ifdef SCHED_TRACE
+/**
+ * Record the new state of a task in the trace ring buffer.
+ */
+void trace_task_state(struct task *task_ptr);
+
+/**
+ * Record in the histogram of its priority the time a task waited in the
+ * ready queue, in cycles, when it starts running.
+ */
+void trace_ready_latency(struct task *task_ptr, uint64_t latency);
+#else
+static inline void trace_task_state(struct task *task_ptr)
+{
+    (void)task_ptr;
+}
+
+static inline void trace_ready_latency(struct task *task_ptr,
+                                       uint64_t     latency)
+{
+    (void)task_ptr;
+    (void)latency;
+}
+#endif
+
+/* see primitive.h for doc */
+int sched_trace(struct sched_trace_event *events, int count);
+int sched_latency(int prio, unsigned long *buckets);
+
+#endif //__SCHED_TRACE_H__
@@ -6,6 +6,7 @@
 #include "hash.h"
 #include "shm.h"
 #include "mem.h"
+#include "slab.h"
 #include "page_allocator.h"
 #include "paging.h"
 #include "task.h"
@@ -61,6 +62,9 @@ struct shp {
     char    *key;
 };
 
+static struct slab_cache shp_cache =
+    SLAB_CACHE_INIT(shp_cache, "shp", sizeof(struct shp));
+
 /**
  * Mapping from a shared page key (its string) to the shared page.
  */
@@ -90,7 +94,13 @@ void *shm_create(const char *key)
     if (virtual_address == NULL)
         return NULL; // out of memory
 
-    struct shp *shp       = mem_alloc(sizeof(struct shp));
+    struct shp *shp       = slab_alloc(&shp_cache);
+    if (shp == NULL) {
+        free_memory(virtual_address);
+        free_physical_page(address, NB_PAGES);
+        mem_free(key_alloc, strlen(key) + 1);
+        return NULL; // out of memory
+    }
     shp->virtual_address  = virtual_address;
     shp->physical_address = address;
     shp->refcount         = 1;
@@ -143,6 +153,6 @@ void shm_release(const char *key)
         free_physical_page(shp->physical_address, NB_PAGES);
         free_memory(shp->virtual_address);
         mem_free(shp->key, strlen(key) + 1);
-        mem_free(shp, sizeof(struct shp));
+        slab_free(&shp_cache, shp);
     }
 }
\ No newline at end of file
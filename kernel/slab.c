@@ -0,0 +1,154 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "slab.h"
+#include "page_allocator.h"
+#include "paging.h"
+#include "task.h"
+#include "errno.h"
+#include "primitive.h"
+
+/**
+ * Header of a slab, at the start of its page.
+ */
+struct slab {
+    link               slabs;
+    struct slab_cache *cache;
+    // Top of the stack of free objects, each one holding the next
+    void              *free;
+    unsigned long      nb_free;
+};
+
+// Objects hold a pointer while free, and are aligned for one
+#define SLAB_OBJ_SIZE(cache)                                                   \
+    (((cache)->size + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+#define SLAB_FIRST_OBJ(slab)                                                   \
+    ((char *)(slab) + ((sizeof(struct slab) + 7) & ~7))
+#define SLAB_NB_OBJS(cache)                                                    \
+    ((PAGE_SIZE - ((sizeof(struct slab) + 7) & ~7)) / SLAB_OBJ_SIZE(cache))
+
+#define OBJ_SLAB(obj) ((struct slab *)((uint32_t)(obj) & ~(PAGE_SIZE - 1)))
+
+// Every cache which ever had a slab
+static LIST_HEAD(slab_caches);
+
+/**
+ * Take a new page for a cache, with all its objects on the free stack.
+ */
+static struct slab *__slab_create(struct slab_cache *cache)
+{
+    struct slab  *slab = try_alloc_physical_page(1);
+    unsigned long size = SLAB_OBJ_SIZE(cache);
+    unsigned long nb   = SLAB_NB_OBJS(cache);
+    char         *obj;
+
+    if (slab == NULL)
+        return NULL;
+
+    if (IS_LINK_NULL(&cache->caches))
+        queue_add_tail(cache, &slab_caches, caches);
+
+    INIT_LINK(&slab->slabs);
+    slab->cache   = cache;
+    slab->free    = NULL;
+    slab->nb_free = nb;
+    // Pushed from the last one, so that the first object is on top
+    obj = SLAB_FIRST_OBJ(slab) + nb * size;
+    while (nb--) {
+        obj -= size;
+        *(void **)obj = slab->free;
+        slab->free    = obj;
+    }
+
+    cache->nb_slabs++;
+    return slab;
+}
+
+void *slab_alloc(struct slab_cache *cache)
+{
+    struct slab *slab;
+    void        *obj;
+
+    if (queue_empty(&cache->partial)) {
+        if (cache->spare) {
+            slab         = cache->spare;
+            cache->spare = NULL;
+        } else {
+            slab = __slab_create(cache);
+            if (slab == NULL)
+                return NULL;
+        }
+        queue_add_tail(slab, &cache->partial, slabs);
+    } else {
+        slab = queue_top(&cache->partial, struct slab, slabs);
+    }
+
+    obj        = slab->free;
+    slab->free = *(void **)obj;
+    if (--slab->nb_free == 0) {
+        queue_del(slab, slabs);
+        queue_add_tail(slab, &cache->full, slabs);
+    }
+
+    cache->nb_active++;
+    cache->nb_allocs++;
+    return obj;
+}
+
+void slab_free(struct slab_cache *cache, void *obj)
+{
+    struct slab *slab = OBJ_SLAB(obj);
+
+    assert(slab->cache == cache);
+
+    *(void **)obj = slab->free;
+    slab->free    = obj;
+    if (slab->nb_free++ == 0) {
+        queue_del(slab, slabs);
+        queue_add_tail(slab, &cache->partial, slabs);
+    }
+
+    cache->nb_active--;
+    cache->nb_frees++;
+
+    if (slab->nb_free < SLAB_NB_OBJS(cache))
+        return;
+
+    // No object in use: the slab is kept as the spare of its cache, or
+    // given back.
+    queue_del(slab, slabs);
+    if (cache->spare == NULL) {
+        cache->spare = slab;
+        return;
+    }
+    free_physical_page(slab, 1);
+    cache->nb_slabs--;
+}
+
+int slabinfo(struct slab_info *info, int count)
+{
+    uint32_t          *dir = (uint32_t *)current()->regs[CR3];
+    struct slab_cache *cache;
+    int                nb  = 0;
+
+    if (count <= 0 || !is_user_addr(dir, (uint32_t)info) ||
+        !is_user_addr(dir, (uint32_t)(info + count) - 1))
+        return -EINVAL;
+
+    queue_for_each(cache, &slab_caches, struct slab_cache, caches)
+    {
+        if (nb == count)
+            break;
+        strncpy(info[nb].name, cache->name, sizeof(info[nb].name) - 1);
+        info[nb].name[sizeof(info[nb].name) - 1] = '\0';
+        info[nb].size    = cache->size;
+        info[nb].slabs   = cache->nb_slabs;
+        info[nb].objects = cache->nb_slabs * SLAB_NB_OBJS(cache);
+        info[nb].active  = cache->nb_active;
+        info[nb].allocs  = cache->nb_allocs;
+        info[nb].frees   = cache->nb_frees;
+        nb++;
+    }
+    return nb;
+}
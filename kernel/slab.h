@@ -0,0 +1,70 @@
+#ifndef __SLAB_H__
+#define __SLAB_H__
+
+#include "queue.h"
+
+struct slab_info;
+
+/**
+ * Cache of small objects of one size, carved out of whole pages.
+ *
+ * A slab is one page from the page allocator: a header, then as many
+ * objects as fit. The free objects of a slab form a stack, linked through
+ * the objects themselves, so an allocation pops the stack of a slab with
+ * free objects and a free pushes the object back on the stack of its slab,
+ * found by rounding its address down to the page. Objects have no header,
+ * and a slab only holds objects of its cache: there is no fragmentation.
+ *
+ * Objects are not constructed: they are handed out in the state they were
+ * freed in.
+ */
+struct slab_cache {
+    const char   *name;
+    unsigned long size;
+    // Slabs with free objects, and slabs without
+    link          partial;
+    link          full;
+    // A slab with no object in use, kept to spare the page allocator a
+    // round trip when the last object of a cache is freed and reallocated.
+    struct slab  *spare;
+    // Statistics
+    unsigned long nb_slabs;
+    unsigned long nb_active;
+    unsigned long nb_allocs;
+    unsigned long nb_frees;
+    // Link in the list of all the caches, see slabinfo()
+    link          caches;
+};
+
+/**
+ * Static initializer of a cache.
+ * @param cache The cache being initialized.
+ * @param name Name of the cache, for slabinfo().
+ * @param size Size of an object, in bytes: less than a page.
+ */
+#define SLAB_CACHE_INIT(cache, name, size)                                     \
+    {                                                                          \
+        (name), (size), LIST_HEAD_INIT((cache).partial),                       \
+            LIST_HEAD_INIT((cache).full), 0, 0, 0, 0, 0, { 0, 0 }              \
+    }
+
+/**
+ * Get an object.
+ * @return NULL if the page allocator is out of memory.
+ */
+void *slab_alloc(struct slab_cache *cache);
+
+/**
+ * Give an object back to its cache.
+ */
+void slab_free(struct slab_cache *cache, void *obj);
+
+/**
+ * Copy the statistics of the caches in use.
+ * @param count Size of info.
+ * @return the number of caches copied, or a negative value if the pointer
+ * is invalid.
+ */
+int slabinfo(struct slab_info *info, int count);
+
+#endif
@@ -69,6 +69,8 @@
 #include "start.h"
 #include "mem.h"
 #include "usermode.h"
+#include "clock.h"
+#include "primitive.h"
 
 /**
  * Space reserved on each task's stack.
@@ -82,12 +84,73 @@
 // after the first context switch
 #define EXTRA_STACK_SPACE 8
 
-// Used for idle process
+// Used for idle process: wait for the next interrupt, with the periodic
+// tick stopped if nothing needs it.
 void halt()
 {
-    for (;;) {
-        __asm__ __volatile__("hlt" ::: "memory");
+    // Nothing else to run: free the processes nobody waits for.
+    reap_zombies();
+    clock_idle_enter();
+    // Syscalls run with interrupts disabled: only enable them while halted.
+    __asm__ __volatile__("sti; hlt; cli" ::: "memory");
+}
+
+/**
+ * Build the address space of a process running an app, with a stack of
+ * size bytes in the first slot, ready to start at USER_START.
+ * @return NULL if out of memory.
+ */
+static struct user_space *__app_space(struct uapp_image *image, int size)
+{
+    struct user_space *space = user_space_create();
+    if (!space)
+        return NULL;
+
+    // The application code and data are copied once in kernel managed memory
+    // (64Mb-1Gb), see get_uapp_image. All the processes of an app map these
+    // pages copy-on-write: code is shared, and a process gets its own copy
+    // of a data page when it first writes to it. The code zone is set first,
+    // so that user_space_put drops the pages mapped on failure.
+    space->code_pages    = image->pages;
+    space->nb_code_pages = image->nb_pages;
+    // The heap is empty until the process calls sbrk.
+    space->heap_start = USER_START + image->nb_pages * PAGE_SIZE;
+    space->brk        = space->heap_start;
+    if (map_cow_pages(space->dir, USER_START, image->pages,
+                      image->nb_pages) < 0) {
+        user_space_put(space);
+        return NULL;
+    }
+
+    // Reserve the stack, in the first slot: it grows downwards from the end
+    // of memory. Only its top page, needed to start the process, is
+    // allocated now, the others when the process first touches them, see
+    // page_fault_handler.
+    uint32_t *stack_top;
+    if (user_stack_create(space, size, &stack_top) < 0) {
+        user_space_put(space);
+        return NULL;
     }
+
+    // Put values needed to the process on the stack. Stack layout:
+    /*
+        +---------------+
+        |   arg         |
+        +---------------+
+        |implicit_exit  |
+        +---------------+
+        |    USER_START |<------------ task start
+        |---------------|
+        |               |
+        |               |
+        +---------------+
+    */
+    uint32_t  size_in_words      = PAGE_SIZE / 4;
+    uint32_t *stack_end          = stack_top;
+    stack_end[size_in_words - 2] = 0; // Unused
+    stack_end[size_in_words - 3] = USER_START;
+
+    return space;
 }
 
 /**
@@ -109,125 +172,105 @@ struct task *start_task(const char *name, unsigned long ssize, int prio,
         return ERR_PTR(-EINVAL);
     }
 
+    // The code of the app, copied on its first start
+    struct uapp_image *image = get_uapp_image(app);
+    if (IS_ERR(image))
+        return ERR_PTR(PTR_ERR(image));
+
+    // Create virtual address space (page directory), see paging.c. A
+    // registered template already holds the code and the initial stack of
+    // the app: it is cloned copy-on-write.
+    // ssize is the number of words to allocate on the stack, but reserve
+    // extra space for exit and arg (see macro comment).
+    // It is built first: it is the only thing to undo on failure.
+    struct user_space *space;
+    int                real_size = ssize * 4 + EXTRA_STACK_SPACE;
+    if (image->template) {
+        space = user_space_clone(image->template, 0);
+        if (space)
+            user_stack_resize(space, 0, real_size);
+    } else {
+        space = __app_space(image, real_size);
+    }
+    if (!space)
+        return ERR_PTR(-ENOMEM);
+
+    // Only the argument differs between the processes of an app.
+    uint32_t *stack_end =
+        user_page_private(space->dir, USER_STACK_END - PAGE_SIZE);
+    if (!stack_end) {
+        user_space_put(space);
+        return ERR_PTR(-ENOMEM);
+    }
+    stack_end[PAGE_SIZE / 4 - 1] = (uint32_t)arg;
+
     pid_t pid = alloc_pid();
     if (pid < 0) {
+        user_space_put(space);
         return ERR_PTR(-EAGAIN);
     }
 
     struct task *self = alloc_empty_task();
-    if (!self)
+    if (!self) {
+        free_pid(pid);
+        user_space_put(space);
         return ERR_PTR(-EAGAIN);
+    }
 
     set_task_starting_up(self);
     set_task_name(self, name);
     set_task_pid(self, pid);
     set_task_priority(self, prio);
+    self->base_priority = prio;
+    refill_time_slice(self);
     set_parent_process(self, current());
+    // Children inherit the scheduling class of their parent. A CPU reservation
+    // is not inherited: children of a SCHED_DEADLINE task are SCHED_RR.
+    if (current() && current()->sched_class != SCHED_DEADLINE)
+        set_task_sched_class(self, current()->sched_class, current()->weight);
+    // They also share the CPU quota of their parent.
+    if (current() && current()->group)
+        sched_group_join(self, current()->group);
     self->first_start = true;
 
-    self->kernel_stack    = mem_alloc(KSTACK_SZ);
+    self->kernel_stack    = alloc_kernel_stack();
     uint8_t *kernel_stack = (uint8_t *)self->kernel_stack;
     kernel_stack += KSTACK_SZ - 1; // Point to the start of stack
     self->regs[ESP0] = (uint32_t)kernel_stack;
 
-    // Create virtual address space (page directory), see paging.c
-    self->regs[CR3] = (uint32_t)page_directory_create();
-
-    // Allocate the application code in kernel managed memory (64-256Mb).
-    // To do so, we'll allocate a number of code_pages, and copy the application's
-    // code there.
-    int code_size = app->end - app->start + 1;
-    // Round up, because we need a full page even if we store only some code.
-    int nb_code_pages = (code_size / PAGE_SIZE) + 1; // 2^12
-
-    uint32_t *code_pages = alloc_physical_page(nb_code_pages);
-    memcpy(code_pages, app->start, code_size);
-
-    // Map virtual memory for the code.
-    map_zone((uint32_t *)self->regs[CR3], USER_START, USER_START + code_size,
-             (uint32_t)code_pages, (uint32_t)code_pages + code_size, RW | US);
-
-    self->code_pages    = code_pages;
-    self->nb_code_pages = nb_code_pages;
-
-    // Allocate a stack in managed memory.
-    // ssize is the number of words to allocate on the stack,
-    // but reserve extra space for exit and arg (see macro comment)
-    int      real_size      = ssize * 4 + EXTRA_STACK_SPACE;
-    int      nb_stack_pages = (real_size / PAGE_SIZE) + 1;
-    uint32_t stack_pages    = (uint32_t)alloc_physical_page(nb_stack_pages);
-    self->stack_pages       = (uint32_t *)stack_pages;
-    self->nb_stack_pages    = nb_stack_pages;
-
-    // Map virtual memory for the stack.
-    // The stack grows downwards and starts at the end of memory.
-    map_zone((uint32_t *)self->regs[CR3], USER_STACK_END - real_size + 1,
-             USER_STACK_END, stack_pages, stack_pages + real_size - 1, RW | US);
-
-    // We've now allocated enough pages for the stack.
-    // But if the stack is not a multiple of PAGE_SIZE, then we've allocated more bytes
-    // than we needed. In the case of the code section above, this isn't an issue,
-    // because the free space is after the code.
-    // However, since the stack grows backwards, the free space needs to be
-    // at the start, not the end!
-    //
-    // For example, here's the allocated when we want to create a stack with a size
-    // of 0x1C00, thus allocating two pages.
-    // Annotated is where we want the stack to go.
-    //
-    //              allocated space (PAGE_SIZE*2)
-    //◄────────────────────────────────────────────────────────────────────────►
-    //┌──────────┼─────────────────────────────┼───────────────────────────────┐
-    //│          │                             │                               │
-    //│free space│  last page stack            │           rest of stack       │
-    //│  0x400   │          0xC00              │              PAGE_SIZE        │
-    //└──────────┴─────────────────────────────┴───────────────────────────────┘
-    //▲         ▲                                                              stack start
-    //│         │
-    //│         │
-    //│         │
-    //address returned
-    //by alloc_physical_page
-    //          │
-    //          │
-    //          address we want
-    //
-    // To go from the address returned by the allocator to the adress we want, we must
-    // fix up the address. To do so, get the last page stack size
-    // get the rest of the space by - PAGE_SIZE, thus giving us the free space.
-    // and add it to our pointer.
-    if (stack_pages & 0xFFFFF000) { // if stack_pages not aligned
-        stack_pages += PAGE_SIZE - (real_size % PAGE_SIZE);
-    }
-
-    // Put values needed to the process on the stack. Stack layout:
-    /*
-        +---------------+
-        |   arg         |
-        +---------------+
-        |implicit_exit  |
-        +---------------+
-        |    USER_START |<------------ task start
-        |---------------|
-        |               |
-        |               |
-        +---------------+
-    */
-    uint32_t  size_in_words      = real_size / 4;
-    uint32_t *stack_end          = (uint32_t *)(stack_pages);
-    stack_end[size_in_words - 1] = (uint32_t)arg;
-    stack_end[size_in_words - 2] = 0; // Unused
-    stack_end[size_in_words - 3] = USER_START;
+    self->space      = space;
+    self->stack_slot = 0;
+    self->regs[CR3]  = (uint32_t)self->space->dir;
 
     // Modify esp to point to user start.
     // 3 words on the stack -> point to last one
-    self->regs[ESP] = (USER_STACK_END + 1) - (3 * 4);
+    self->regs[ESP] = USER_STACK_END - (3 * 4);
 
     return self;
 }
 
+int start_template(const char *name)
+{
+    struct uapps *app = get_uapp_by_name(name);
+    if (IS_ERR(app))
+        return -EINVAL;
+
+    struct uapp_image *image = get_uapp_image(app);
+    if (IS_ERR(image))
+        return PTR_ERR(image);
+    if (!image->template)
+        image->template = __app_space(image, EXTRA_STACK_SPACE);
+    if (!image->template)
+        return -ENOMEM;
+    return 0;
+}
+
 int start(const char *name, unsigned long ssize, int prio, void *arg)
 {
+    // When the CPU is never idle, give back the memory of dead processes
+    // before taking more.
+    reap_zombies();
+
     struct task *task = start_task(name, ssize, prio, arg);
     if (IS_ERR(task)) {
         return PTR_ERR(task);
@@ -237,7 +280,7 @@ int start(const char *name, unsigned long ssize, int prio, void *arg)
     set_task_ready(task);
     add_to_global_list(task);
 
-    if (prio >= current()->priority)
+    if (!task_outranks(current(), task))
         schedule();
 
     return task->pid;
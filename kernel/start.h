@@ -3,11 +3,21 @@
 
 // User start virtual address, defined in kernel.lds
 #define USER_START 0x40000000
+// The heap of a process starts after its code, and cannot grow past this
+#define USER_HEAP_END 0x80000000
+// Zone of the mappings made by mmap, between the heap and the stacks
+#define USER_MMAP_START USER_HEAP_END
+#define USER_MMAP_END 0xF0000000
 // Our choice for the stack: here starts at end of adress space
 // and grows downwards
 #define USER_STACK_END 0xFFF00000
+// Each thread of a process has its stack in a slot, right below the one of
+// the previous thread
+#define STACK_SLOT_SIZE 0x10000
+#define STACK_SLOT_TOP(slot) (USER_STACK_END - (slot)*STACK_SLOT_SIZE)
 
 int  start(const char *name, unsigned long ssize, int prio, void *arg);
+int  start_template(const char *name);
 void start_idle(void);
 
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "stdio.h"
 #include "stdint.h"
 #include "clock.h"
+#include "timer.h"
 #include "kbd.h"
 #include "start.h"
 #include "task.h"
@@ -26,6 +27,8 @@ void kernel_start(void)
     printf("\f"); // clear the screen
 
     /* Kernel initialization */
+    init_scheduler();
+    init_timers();
     init_clock();
     init_keyboard_handler();
     init_page_fault_handler();
@@ -35,6 +38,9 @@ void kernel_start(void)
     uapp_init();
 
     /* Do any quick tests here, before start_idle(). */
+#ifdef PAGE_ALLOC_BENCH
+    page_alloc_bench();
+#endif
 
     // Start and switch into idle process.
     start_idle();
@@ -1,4 +1,6 @@
 #include "primitive.h"
+#include "fork.h"
+#include "paging.h"
 #include "interrupts.h"
 #include "isr.h"
 #include "syscall_handler.h"
@@ -51,6 +53,22 @@ void *syscalls[NUM_SYSCALLS] = {
     [31] = halt,
     [32] = ps,
     [33] = change_color,
+    [34] = sched_setclass,
+    [35] = sched_setdeadline,
+    [36] = sched_getdlstats,
+    [37] = sched_setquota,
+    [38] = getcputime,
+    [39] = sched_trace,
+    [40] = sched_latency,
+    [41] = psetproto,
+    [42] = fork,
+    [43] = sys_thread_create,
+    [44] = start_template,
+    [45] = sys_sbrk,
+    [46] = mmap,
+    [47] = munmap,
+    [48] = slabinfo,
+    [49] = sched_timeslice,
 };
 
 /**
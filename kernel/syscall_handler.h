@@ -1,7 +1,7 @@
 #ifndef __SYSCALL_HANDLER_H__
 #define __SYSCALL_HANDLER_H__
 
-#define NUM_SYSCALLS 34
+#define NUM_SYSCALLS 50
 
 // Definitions accessible from asm code
 int   num_syscalls;
@@ -3,7 +3,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdlib.h>
 #include "mem.h"
+#include "obj_cache.h"
 #include "queue.h"
 #include "msg.h"
 #include "task.h"
@@ -13,9 +15,21 @@
 #include "primitive.h"
 #include "usermode.h"
 #include "cpu.h"
+#include "multiboot.h"
+#include "errno.h"
+#include "div64.h"
+#include "sched_group.h"
+#include "pid_allocator.h"
+#include "cputime.h"
+#include "sched_trace.h"
 
 static void debug_print(void);
 
+// Priority bands, each with its own time slice (see band_time_slices)
+#define NB_PRIO_BANDS SCHED_PRIO_BANDS
+#define PRIO_BAND_SIZE ((MAX_PRIO - MIN_PRIO + 1) / NB_PRIO_BANDS)
+#define PRIO_BAND(prio) (((prio)-MIN_PRIO) / PRIO_BAND_SIZE)
+
 /*********************
 * GENERIC FUNCTIONS *
 ********************/
@@ -25,17 +39,44 @@ inline static int __is_state(struct task *task_ptr, int state)
     return task_ptr->state == state;
 }
 
+static void ready_queue_del(struct task *task_ptr);
+static void fair_update_min_vruntime(int prio);
+static void dl_task_wakeup(struct task *task_ptr);
+static void dl_replenish(void *data);
+
+/**
+ * Remove a task from the queue of its current state, if it is in one.
+ */
+inline static void __leave_state_queue(struct task *task_ptr)
+{
+    if (is_current(task_ptr) || is_task_starting_up(task_ptr) ||
+        is_task_interrupted_msg(task_ptr)) // queue managed by msg.c
+        return;
+
+    if (is_task_ready(task_ptr))
+        ready_queue_del(task_ptr);
+    else if (is_task_sleeping(task_ptr))
+        timer_del(&task_ptr->sleep_timer);
+    else if (is_task_throttled(task_ptr)) {
+        // Throttled either by its group, or by its deadline reservation
+        if (!IS_LINK_NULL(&task_ptr->tasks))
+            queue_del(task_ptr, tasks);
+        timer_del(&task_ptr->dl_timer);
+    }
+    else
+        queue_del(task_ptr, tasks);
+}
+
 inline static void __set_task_state(struct task *task_ptr, int state,
                                     struct list_link *queue_ptr)
 {
     if (task_ptr->state == state)
         return;
 
-    if (!is_current(task_ptr) && !is_task_starting_up(task_ptr) &&
-        !is_task_interrupted_msg(task_ptr)) // queue managed by msg.c
-        queue_del(task_ptr, tasks);
+    __leave_state_queue(task_ptr);
 
     task_ptr->state = state;
+    trace_task_state(task_ptr);
     queue_add(task_ptr, queue_ptr, struct task, tasks, priority);
 }
 
@@ -73,20 +114,142 @@ int is_task_running(struct task *task_ptr)
 
 void set_task_running(struct task *task_ptr)
 {
-    if (!is_task_starting_up(task_ptr) && !is_task_running(task_ptr)) {
-        queue_del(task_ptr, tasks);
-        RESET_LINK(&task_ptr->tasks);
+    if (is_task_ready(task_ptr)) {
+        ready_queue_del(task_ptr);
+        trace_ready_latency(task_ptr, cputime_start_running(task_ptr));
     }
 
     task_ptr->state = TASK_RUNNING;
     __running_task  = task_ptr;
+    fair_update_min_vruntime(task_ptr->priority);
+    trace_task_state(task_ptr);
 }
 
 /**************
 * READY TASKS *
 ***************/
 
-struct list_link tasks_ready_queue = LIST_HEAD_INIT(tasks_ready_queue);
+/*
+ * Ready tasks are kept in one FIFO list per priority level. A bitmap records
+ * which levels are non-empty, and a summary word records which bitmap words
+ * are non-zero: finding the highest priority ready task takes two bsr,
+ * and adding or removing a task never walks a list.
+ *
+ * SCHED_FAIR tasks of a level are in a second list, sorted by vruntime.
+ * They run when no SCHED_RR task of their level is ready.
+ *
+ * SCHED_DEADLINE tasks are outside of the levels, in a single list sorted
+ * by absolute deadline, and run first.
+ */
+#define READY_LEVELS (MAX_PRIO + 1)
+#define READY_BITMAP_WORDS ((READY_LEVELS + 31) / 32)
+
+static struct list_link ready_queues[READY_LEVELS];
+static struct list_link fair_queues[READY_LEVELS];
+static struct list_link edf_queue = LIST_HEAD_INIT(edf_queue);
+static uint32_t         ready_bitmap[READY_BITMAP_WORDS];
+static uint32_t         ready_summary = 0;
+
+// Lowest vruntime of the SCHED_FAIR tasks of each level, running or ready.
+// It only moves forward, like the vruntimes: a task joining a level starts
+// from there, at the head of the tasks already in it.
+static uint64_t fair_min_vruntime[READY_LEVELS];
+
+static bool is_task_fair(struct task *task_ptr)
+{
+    return task_ptr->sched_class == SCHED_FAIR;
+}
+
+static bool is_task_deadline(struct task *task_ptr)
+{
+    return task_ptr->sched_class == SCHED_DEADLINE;
+}
+
+static void fair_update_min_vruntime(int prio)
+{
+    struct task *running  = current();
+    uint64_t     vruntime = UINT64_MAX;
+    struct task *head;
+
+    // The running task counts even while it is put back in the queue, so
+    // that a preempted task keeps its vruntime.
+    if (running && is_task_fair(running) && running->priority == prio)
+        vruntime = running->vruntime;
+
+    if (!queue_empty(&fair_queues[prio])) {
+        head = queue_entry(fair_queues[prio].next, struct task, tasks);
+        if (head->vruntime < vruntime)
+            vruntime = head->vruntime;
+    }
+
+    if (vruntime != UINT64_MAX && vruntime > fair_min_vruntime[prio])
+        fair_min_vruntime[prio] = vruntime;
+}
+
+static void ready_queue_add(struct task *task_ptr)
+{
+    int prio = task_ptr->priority;
+
+    task_ptr->ready_stamp = rdtsc();
+
+    if (is_task_deadline(task_ptr)) {
+        queue_add(task_ptr, &edf_queue, struct task, tasks, dl_abs_deadline);
+        return;
+    }
+    if (is_task_fair(task_ptr)) {
+        // A task coming back from a sleep or a new task does not get to
+        // catch up on the CPU time the others used meanwhile.
+        fair_update_min_vruntime(prio);
+        if (task_ptr->vruntime < fair_min_vruntime[prio])
+            task_ptr->vruntime = fair_min_vruntime[prio];
+        queue_add(task_ptr, &fair_queues[prio], struct task, tasks, vruntime);
+    } else {
+        queue_add_tail(task_ptr, &ready_queues[prio], tasks);
+    }
+    ready_bitmap[prio / 32] |= 1u << (prio % 32);
+    ready_summary |= 1u << (prio / 32);
+}
+
+static void ready_queue_del(struct task *task_ptr)
+{
+    int prio = task_ptr->priority;
+
+    queue_del(task_ptr, tasks);
+    if (is_task_deadline(task_ptr))
+        return;
+    if (queue_empty(&ready_queues[prio]) && queue_empty(&fair_queues[prio])) {
+        ready_bitmap[prio / 32] &= ~(1u << (prio % 32));
+        if (ready_bitmap[prio / 32] == 0)
+            ready_summary &= ~(1u << (prio / 32));
+    }
+}
+
+struct task *ready_queue_top(void)
+{
+    if (!queue_empty(&edf_queue))
+        return queue_entry(edf_queue.next, struct task, tasks);
+
+    if (ready_summary == 0)
+        return NULL;
+
+    int               word  = bsr(ready_summary);
+    int               prio  = word * 32 + bsr(ready_bitmap[word]);
+    struct list_link *level = &ready_queues[prio];
+
+    // Lowest vruntime first: fair_queues are sorted in ascending order.
+    if (queue_empty(level))
+        level = &fair_queues[prio];
+    return queue_entry(level->next, struct task, tasks);
+}
+
+bool task_outranks(struct task *a, struct task *b)
+{
+    if (is_task_deadline(a) != is_task_deadline(b))
+        return is_task_deadline(a);
+    if (is_task_deadline(a))
+        return a->dl_abs_deadline < b->dl_abs_deadline;
+    return a->priority > b->priority;
+}
 
 int is_task_ready(struct task *task_ptr)
 {
@@ -95,14 +258,26 @@ int is_task_ready(struct task *task_ptr)
 
 void set_task_ready(struct task *task_ptr)
 {
-    __set_task_state(task_ptr, TASK_READY, &tasks_ready_queue);
+    if (is_task_ready(task_ptr))
+        return;
+
+    if (!is_task_running(task_ptr))
+        dl_task_wakeup(task_ptr);
+
+    __leave_state_queue(task_ptr);
+
+    task_ptr->state = TASK_READY;
+    trace_task_state(task_ptr);
+    ready_queue_add(task_ptr);
 }
 
 void set_task_ready_or_running(struct task *task_ptr)
 {
+    dl_task_wakeup(task_ptr);
     task_ptr->state = TASK_READY;
-    queue_add(task_ptr, &tasks_ready_queue, struct task, tasks, priority);
-    if (task_ptr->priority > current()->priority) {
+    trace_task_state(task_ptr);
+    ready_queue_add(task_ptr);
+    if (task_outranks(task_ptr, current())) {
         schedule();
     }
 }
@@ -111,8 +286,8 @@ void set_task_ready_or_running(struct task *task_ptr)
 * SLEEPING TASKS *
 ******************/
 
-static struct list_link tasks_sleeping_queue =
-    LIST_HEAD_INIT(tasks_sleeping_queue);
+// Sleeping tasks are in no queue: they are only referenced by their
+// sleep_timer, in the timer wheel (see timer.c).
 
 int is_task_sleeping(struct task *task_ptr)
 {
@@ -121,20 +296,44 @@ int is_task_sleeping(struct task *task_ptr)
 
 void set_task_sleeping(struct task *task_ptr)
 {
-    __set_task_state(task_ptr, TASK_SLEEPING, &tasks_sleeping_queue);
+    if (is_task_sleeping(task_ptr))
+        return;
+
+    __leave_state_queue(task_ptr);
+
+    task_ptr->state = TASK_SLEEPING;
+    trace_task_state(task_ptr);
+    timer_add(&task_ptr->sleep_timer, task_ptr->wake_time);
 }
 
-static void try_wakeup_tasks(void)
+static void wakeup_task(void *data)
 {
-    struct task *cur;
-    struct task *tmp;
-    queue_for_each_safe(cur, tmp, &tasks_sleeping_queue, struct task, tasks)
-    {
-        if (current_clock() >= cur->wake_time) {
-            cur->wake_time = 0;
-            set_task_ready(cur);
-        }
-    }
+    struct task *task_ptr = data;
+
+    task_ptr->wake_time = 0;
+    set_task_ready(task_ptr);
+}
+
+/******************
+* THROTTLED TASKS *
+******************/
+
+// Throttled tasks used up their CPU time for the current period. Tasks of a
+// SCHED_DEADLINE reservation are in no queue: their dl_timer makes them ready
+// again at the next period. Tasks of a group out of quota are on the
+// throttled list of the group (see sched_group.c).
+
+int is_task_throttled(struct task *task_ptr)
+{
+    return __is_state(task_ptr, TASK_THROTTLED);
+}
+
+void set_task_throttled(struct task *task_ptr)
+{
+    __leave_state_queue(task_ptr);
+
+    task_ptr->state = TASK_THROTTLED;
+    trace_task_state(task_ptr);
 }
 
 /***************
@@ -142,6 +341,10 @@ static void try_wakeup_tasks(void)
 ****************/
 
 static struct list_link tasks_zombie_queue = LIST_HEAD_INIT(tasks_zombie_queue);
+// Zombie tasks nobody will wait for, freed by reap_zombies()
+static LIST_HEAD(tasks_orphan_queue);
+
+static void dl_release_bw(struct task *task_ptr);
 
 int is_task_zombie(struct task *task_ptr)
 {
@@ -150,19 +353,44 @@ int is_task_zombie(struct task *task_ptr)
 
 void set_task_zombie(struct task *task_ptr)
 {
-    __set_task_state(task_ptr, TASK_ZOMBIE, &tasks_zombie_queue);
+    if (is_task_zombie(task_ptr))
+        return;
+
+    __leave_state_queue(task_ptr);
+
+    if (is_task_deadline(task_ptr))
+        dl_release_bw(task_ptr);
+    sched_group_leave(task_ptr);
+
+    // Now that the task is zombie, use the task->priority field
+    // to indicate when the task died, since the zombie queue is sorted on it.
+    // When we will wake up tasks with waitpid, they will stay in the same order.
+
+    // Why UINT32_MAX? In the queue, things are ordered from highest to lowest
+    // and we want the opposite order, lowest (earliest died process) should be
+    // first.
+    task_ptr->priority = UINT32_MAX - current_clock();
+
+    task_ptr->state = TASK_ZOMBIE;
+    trace_task_state(task_ptr);
+    queue_add(task_ptr, &tasks_zombie_queue, struct task, tasks, priority);
+}
+
+void set_zombie_orphan(struct task *task_ptr)
+{
+    queue_del(task_ptr, tasks);
+    queue_add_tail(task_ptr, &tasks_orphan_queue, tasks);
 }
 
-static void reap_zombies(void)
+void reap_zombies(void)
 {
     struct task *cur;
     struct task *tmp;
-    queue_for_each_safe(cur, tmp, &tasks_zombie_queue, struct task, tasks)
+    queue_for_each_safe(cur, tmp, &tasks_orphan_queue, struct task, tasks)
     {
-        if (!is_current(cur) &&
-            (is_idle(cur->parent) || is_task_zombie(cur->parent))) {
+        // A task killing itself is still running on its kernel stack.
+        if (!is_current(cur))
             free_task(cur);
-        }
     }
 }
 
@@ -191,15 +419,16 @@ void set_task_interrupted_child(struct task *task_ptr)
 static struct list_link tasks_interrupted_msg_queue =
     LIST_HEAD_INIT(tasks_interrupted_msg_queue);
 
+/**
+ * Ready tasks are not in a single queue: set_task_priority() moves them
+ * between levels, so NULL is returned for TASK_READY.
+ * Sleeping tasks are sorted by wake time only, NULL is returned as well.
+ */
 struct list_link *queue_from_state(int state, int pid)
 {
     switch (state) {
-    case TASK_READY:
-        return &tasks_ready_queue;
     case TASK_ZOMBIE:
         return &tasks_zombie_queue;
-    case TASK_SLEEPING:
-        return &tasks_sleeping_queue;
     case TASK_INTERRUPTED_CHILD:
         return &tasks_interrupted_child_queue;
     case TASK_INTERRUPTED_MSG:
@@ -220,6 +449,7 @@ void set_task_interrupted_msg(struct task *task_ptr)
 {
     // Do not use __set_task_state, sicne it thinks it manages its own queue
     task_ptr->state = TASK_INTERRUPTED_MSG;
+    trace_task_state(task_ptr);
     schedule();
 }
 
@@ -228,25 +458,28 @@ void set_task_interrupted_msg(struct task *task_ptr)
 ********************/
 
 /**
- * A list containing all tasks on the system.
+ * A list containing all tasks on the system, in creation order: tasks are
+ * found by pid in the pid table, and adding one must not walk the list.
  */
 static LIST_HEAD(global_task_list);
 
 void add_to_global_list(struct task *self)
 {
-    queue_add(self, &global_task_list, struct task, global_tasks, pid);
+    queue_add_tail(self, &global_task_list, global_tasks);
+    pid_set_task(self->pid, self);
 }
 
 void remove_from_global_list(struct task *self)
 {
     queue_del(self, global_tasks);
+    pid_set_task(self->pid, NULL);
 }
 
 void ps()
 {
     printf("ps");
     struct task *p;
-    printf("pid\tprio\tstate\tname\n");
+    printf("pid\tprio\tstate\tuser\tkernel\twait\tvcsw\tivcsw\tname\n");
     queue_for_each(p, &global_task_list, struct task, global_tasks)
     {
         printf("%d\t%d\t", p->pid, p->priority);
@@ -270,10 +503,18 @@ void ps()
         case TASK_INTERRUPTED_CHILD:
             printf("child");
             break;
+        case TASK_THROTTLED:
+            printf("throttled");
+            break;
         default:
             printf("{%d}", p->state);
         }
-        printf("\t");
+        // CPU times in millions of cycles
+        printf("\t%lu\t%lu\t%lu\t%lu\t%lu",
+               (unsigned long)div64(p->cputime.user, 1000000),
+               (unsigned long)div64(p->cputime.kernel, 1000000),
+               (unsigned long)div64(p->cputime.wait, 1000000),
+               p->cputime.voluntary, p->cputime.involuntary);
         printf("\t%s", p->comm);
         printf("\n");
     }
@@ -283,16 +524,46 @@ void ps()
 /********************
 * Memory allocation *
 ********************/
+
+/*
+ * Tasks and kernel stacks are recycled through object caches. A cached task
+ * keeps what its constructor set up: unlinked list links, and its timers
+ * bound to it.
+ */
+static void __task_ctor(void *obj)
+{
+    struct task *task_ptr = obj;
+
+    INIT_LINK(&task_ptr->tasks);
+    INIT_LINK(&task_ptr->siblings);
+    INIT_LINK(&task_ptr->global_tasks);
+    timer_init(&task_ptr->sleep_timer, wakeup_task, task_ptr);
+    timer_init(&task_ptr->dl_timer, dl_replenish, task_ptr);
+}
+
+static struct obj_cache task_cache =
+    OBJ_CACHE_INIT("task", sizeof(struct task), __task_ctor, NULL, NULL);
+
+static struct obj_cache kstack_cache =
+    OBJ_CACHE_INIT("kernel_stack", KSTACK_SZ, NULL, NULL, NULL);
+
 struct task *alloc_empty_task()
 {
     struct task *task_ptr;
 
-    task_ptr = mem_alloc(sizeof(struct task));
+    task_ptr = obj_cache_alloc(&task_cache);
     if (!task_ptr)
         goto error;
 
-    INIT_LINK(&task_ptr->tasks);
     INIT_LIST_HEAD(&task_ptr->children);
+    memset(&task_ptr->dl_stats, 0, sizeof(task_ptr->dl_stats));
+    task_ptr->sched_class = SCHED_RR;
+    task_ptr->weight      = FAIR_DEFAULT_WEIGHT;
+    task_ptr->vruntime    = 0;
+    task_ptr->group       = NULL;
+    memset(&task_ptr->cputime, 0, sizeof(task_ptr->cputime));
+    task_ptr->cputime_stamp = rdtsc();
+    task_ptr->ready_stamp   = 0;
 
     return task_ptr;
 
@@ -300,6 +571,11 @@ error:
     return NULL;
 }
 
+void *alloc_kernel_stack(void)
+{
+    return obj_cache_alloc(&kstack_cache);
+}
+
 void free_task(struct task *task_ptr)
 {
     if (!IS_LINK_NULL(&task_ptr->tasks))
@@ -308,15 +584,17 @@ void free_task(struct task *task_ptr)
     if (!IS_LINK_NULL(&task_ptr->siblings))
         queue_del(task_ptr, siblings);
 
-    // Since the task is zombie, we can freely dispose of its page directory.
-    page_directory_destroy((uint32_t *)task_ptr->regs[CR3]);
+    // Back to the state of the constructor
+    timer_del(&task_ptr->sleep_timer);
+    timer_del(&task_ptr->dl_timer);
 
-    // Free the various pages.
-    free_physical_page(task_ptr->stack_pages, task_ptr->nb_stack_pages);
-    free_physical_page(task_ptr->code_pages, task_ptr->nb_code_pages);
+    // Since the task is zombie, we can freely dispose of its stack. The rest
+    // of the address space goes with its last thread.
+    user_stack_destroy(task_ptr->space, task_ptr->stack_slot);
+    user_space_put(task_ptr->space);
 
-    mem_free(task_ptr->kernel_stack, sizeof(uint8_t) * KSTACK_SZ);
-    mem_free(task_ptr, sizeof(struct task));
+    obj_cache_free(&kstack_cache, task_ptr->kernel_stack);
+    obj_cache_free(&task_cache, task_ptr);
 }
 
 /******************
@@ -328,9 +606,22 @@ inline void set_task_name(struct task *task_ptr, const char *name)
     strncpy(task_ptr->comm, name, COMM_LEN);
 }
 
-inline void set_task_priority(struct task *task_ptr, int priority)
+void set_task_priority(struct task *task_ptr, int priority)
 {
-    task_ptr->priority = priority;
+    // The quantum of a new band applies right away.
+    bool new_band = PRIO_BAND(task_ptr->priority) != PRIO_BAND(priority);
+
+    // A ready task becomes the youngest of its new priority level.
+    if (is_task_ready(task_ptr)) {
+        ready_queue_del(task_ptr);
+        task_ptr->priority = priority;
+        ready_queue_add(task_ptr);
+    } else {
+        task_ptr->priority = priority;
+    }
+
+    if (new_band)
+        refill_time_slice(task_ptr);
 }
 
 inline void set_task_pid(struct task *task_ptr, pid_t pid)
@@ -351,6 +642,213 @@ inline void set_parent_process(struct task *child, struct task *parent)
     }
 }
 
+/***************
+* TIME SLICES *
+***************/
+
+/*
+ * Time slice, in ticks, of each priority band. Band i holds the priorities
+ * from MIN_PRIO + i * PRIO_BAND_SIZE to MIN_PRIO + (i + 1) * PRIO_BAND_SIZE - 1.
+ * Set at boot with "timeslice=<band 0>,<band 1>,..." on the kernel command
+ * line, for instance to give longer slices to low priority batch jobs.
+ */
+#define TIME_SLICE_ARG "timeslice="
+
+static uint32_t band_time_slices[NB_PRIO_BANDS] = { 1, 1, 1, 1 };
+
+static void parse_time_slices(const char *cmdline)
+{
+    const char *arg = strstr(cmdline, TIME_SLICE_ARG);
+    if (!arg)
+        return;
+
+    arg += strlen(TIME_SLICE_ARG);
+    for (int band = 0; band < NB_PRIO_BANDS; band++) {
+        char         *end;
+        unsigned long slice = strtoul(arg, &end, 10);
+        if (end == arg)
+            break;
+        if (slice > 0)
+            band_time_slices[band] = slice;
+        if (*end != ',')
+            break;
+        arg = end + 1;
+    }
+}
+
+void refill_time_slice(struct task *task_ptr)
+{
+    task_ptr->time_slice = band_time_slices[PRIO_BAND(task_ptr->priority)];
+}
+
+// Longest spec taken by sched_timeslice(), as long as the boot argument
+#define TIME_SLICE_SPEC_MAX 64
+
+int sched_timeslice(const char *spec, unsigned long *slices)
+{
+    uint32_t *dir = (uint32_t *)current()->regs[CR3];
+    char      buf[TIME_SLICE_SPEC_MAX];
+    int       len = 0;
+
+    if (slices && (!is_user_addr(dir, (uint32_t)slices) ||
+                   !is_user_addr(dir, (uint32_t)(slices + NB_PRIO_BANDS) - 1)))
+        return -EINVAL;
+
+    // The spec is copied first: it is checked byte by byte.
+    if (spec) {
+        do {
+            if (len == TIME_SLICE_SPEC_MAX ||
+                !is_user_addr(dir, (uint32_t)(spec + len)))
+                return -EINVAL;
+            buf[len] = spec[len];
+        } while (buf[len++]);
+    }
+
+    if (slices) {
+        for (int band = 0; band < NB_PRIO_BANDS; band++)
+            slices[band] = band_time_slices[band];
+    }
+
+    // Same format as the boot argument, without its name
+    if (spec) {
+        char arg[sizeof(TIME_SLICE_ARG) + TIME_SLICE_SPEC_MAX] = TIME_SLICE_ARG;
+        strcat(arg, buf);
+        parse_time_slices(arg);
+    }
+    return 0;
+}
+
+/*******************
+* DEADLINE TASKS *
+*******************/
+
+/*
+ * Admission control: a SCHED_DEADLINE task reserves runtime / deadline of
+ * the CPU, as a fixed point fraction of EDF_BW_ONE. EDF meets all deadlines
+ * as long as the reserved fractions add up to at most one; some room is
+ * left for the other classes.
+ */
+#define EDF_BW_SHIFT 16
+#define EDF_BW_ONE (1u << EDF_BW_SHIFT)
+#define EDF_MAX_BW (EDF_BW_ONE / 100 * 95)
+
+static uint32_t edf_total_bw = 0;
+
+static void dl_start_job(struct task *task_ptr, uint32_t release)
+{
+    task_ptr->dl_release      = release;
+    task_ptr->dl_abs_deadline = release + task_ptr->dl_deadline;
+    task_ptr->dl_runtime_left = task_ptr->dl_runtime;
+    task_ptr->dl_missed       = false;
+    task_ptr->dl_stats.jobs++;
+}
+
+/*
+ * A task waking up starts a new job if the current one cannot use its
+ * runtime left before its deadline without exceeding its bandwidth: this
+ * is what happens to a periodic task waking up for its next period.
+ */
+static void dl_task_wakeup(struct task *task_ptr)
+{
+    uint32_t now = current_clock();
+
+    if (!is_task_deadline(task_ptr))
+        return;
+
+    if (now >= task_ptr->dl_abs_deadline ||
+        (uint64_t)task_ptr->dl_runtime_left * task_ptr->dl_deadline >
+            (uint64_t)(task_ptr->dl_abs_deadline - now) * task_ptr->dl_runtime)
+        dl_start_job(task_ptr, now);
+}
+
+static void dl_replenish(void *data)
+{
+    struct task *task_ptr = data;
+
+    dl_start_job(task_ptr, task_ptr->dl_release + task_ptr->dl_period);
+    set_task_ready(task_ptr);
+}
+
+/**
+ * Account a tick of CPU time to a running SCHED_DEADLINE task.
+ * @return true if the task used up its runtime and got throttled.
+ */
+static bool dl_account_tick(struct task *task_ptr)
+{
+    if (!task_ptr->dl_missed && current_clock() > task_ptr->dl_abs_deadline) {
+        task_ptr->dl_missed = true;
+        task_ptr->dl_stats.misses++;
+    }
+
+    if (--task_ptr->dl_runtime_left > 0)
+        return false;
+
+    task_ptr->dl_stats.throttled++;
+    set_task_throttled(task_ptr);
+    timer_add(&task_ptr->dl_timer,
+              task_ptr->dl_release + task_ptr->dl_period);
+    return true;
+}
+
+static void dl_release_bw(struct task *task_ptr)
+{
+    edf_total_bw -= task_ptr->dl_bw;
+    task_ptr->dl_bw = 0;
+}
+
+int set_task_deadline(struct task *task_ptr, uint32_t runtime,
+                      uint32_t deadline, uint32_t period)
+{
+    uint32_t bw     = div64((uint64_t)runtime << EDF_BW_SHIFT, deadline);
+    uint32_t old_bw = is_task_deadline(task_ptr) ? task_ptr->dl_bw : 0;
+    bool     ready  = is_task_ready(task_ptr);
+
+    if (edf_total_bw - old_bw + bw > EDF_MAX_BW)
+        return -EBUSY;
+    edf_total_bw += bw - old_bw;
+
+    if (ready)
+        ready_queue_del(task_ptr);
+
+    task_ptr->sched_class = SCHED_DEADLINE;
+    task_ptr->dl_runtime  = runtime;
+    task_ptr->dl_deadline = deadline;
+    task_ptr->dl_period   = period;
+    task_ptr->dl_bw       = bw;
+
+    memset(&task_ptr->dl_stats, 0, sizeof(task_ptr->dl_stats));
+    task_ptr->dl_stats.runtime  = runtime;
+    task_ptr->dl_stats.deadline = deadline;
+    task_ptr->dl_stats.period   = period;
+    dl_start_job(task_ptr, current_clock());
+
+    if (ready)
+        ready_queue_add(task_ptr);
+    else if (is_task_throttled(task_ptr))
+        set_task_ready(task_ptr);
+    return 0;
+}
+
+void set_task_sched_class(struct task *task_ptr, int sched_class,
+                          uint32_t weight)
+{
+    bool ready = is_task_ready(task_ptr);
+
+    if (ready)
+        ready_queue_del(task_ptr);
+
+    if (is_task_deadline(task_ptr))
+        dl_release_bw(task_ptr);
+
+    task_ptr->sched_class = sched_class;
+    task_ptr->weight      = weight;
+
+    if (ready)
+        ready_queue_add(task_ptr);
+    else if (is_task_throttled(task_ptr))
+        set_task_ready(task_ptr);
+}
+
 /*************
  * IDLE task *
  *************/
@@ -376,6 +874,15 @@ void set_idle(struct task *task_ptr)
 * SCHEDULING *
 **************/
 
+void init_scheduler(void)
+{
+    for (int prio = 0; prio < READY_LEVELS; prio++) {
+        INIT_LIST_HEAD(&ready_queues[prio]);
+        INIT_LIST_HEAD(&fair_queues[prio]);
+    }
+    parse_time_slices(multiboot_cmdline());
+}
+
 static bool __preempt_enabled = false;
 
 void preempt_enable(void)
@@ -399,25 +906,39 @@ void schedule(void)
     struct task *new_task;
     struct task *old_task;
 
-    try_wakeup_tasks();
-    reap_zombies();
-
-    new_task = queue_top(&tasks_ready_queue, struct task, tasks);
     old_task = current();
+    // Tasks of a group out of quota wait for the next period, whatever
+    // their priority.
+    if (is_task_running(old_task) && sched_group_throttled(old_task))
+        sched_group_park(old_task);
+
+    new_task = ready_queue_top();
+    while (new_task && sched_group_throttled(new_task)) {
+        sched_group_park(new_task);
+        new_task = ready_queue_top();
+    }
 
-    if (new_task == NULL || old_task == new_task) {
+    if (new_task == NULL) {
+        return;
+    }
+    // The current task went back to the ready queue (it woke up before being
+    // switched out) and is still the best choice: keep running it.
+    if (old_task == new_task) {
+        set_task_running(new_task);
         return;
     }
     // "Un processus ne s'exécute jamais tant qu'il reste un
     // autre processus de priorité supérieure actif ou activable."
-    if (is_task_running(old_task) && old_task->priority > new_task->priority) {
+    if (is_task_running(old_task) && task_outranks(old_task, new_task)) {
         return;
     }
 
-    if (is_task_running(old_task)) {
+    bool preempted = is_task_running(old_task);
+    if (preempted) {
         set_task_ready(old_task);
     }
     set_task_running(new_task);
+    cputime_switch(old_task, new_task, preempted);
 
     if (new_task->first_start) {
         new_task->first_start = false;
@@ -427,6 +948,42 @@ void schedule(void)
     }
 }
 
+void schedule_tick(void)
+{
+    struct task *self       = current();
+    struct task *next       = ready_queue_top();
+    bool         over_quota = sched_group_charge(self);
+
+    if (is_task_deadline(self) && dl_account_tick(self)) {
+        schedule();
+        return;
+    }
+
+    // schedule() parks the task until the next period of its group.
+    if (over_quota) {
+        schedule();
+        return;
+    }
+
+    // Heavier tasks see their virtual runtime grow slower, and get picked
+    // more often.
+    if (is_task_fair(self))
+        self->vruntime += (FAIR_DEFAULT_WEIGHT << 10) / self->weight;
+
+    if (self->time_slice > 1) {
+        self->time_slice--;
+        // Only a higher priority task can take the CPU before the end of
+        // the slice.
+        if (next && task_outranks(next, self))
+            schedule();
+        return;
+    }
+
+    // Slice used up: go to the tail of our priority level.
+    refill_time_slice(self);
+    schedule();
+}
+
 /*****************
 * Misc functions *
 *****************/
@@ -437,15 +994,8 @@ struct task *pid_to_task(pid_t pid)
         return current();
     }
 
-    struct task *cur;
-    queue_for_each(cur, &global_task_list, struct task, global_tasks)
-    {
-        if (cur->pid == pid) {
-            return cur;
-        }
-    }
-
-    return NULL;
+    // Only tasks of the global list are in the pid table.
+    return pid_get_task(pid);
 }
 
 /*******************
@@ -454,8 +1004,15 @@ struct task *pid_to_task(pid_t pid)
 
 void wait_clock(unsigned long clock)
 {
-    current()->wake_time = clock;
-    set_task_sleeping(current());
+    struct task *self = current();
+
+    if (clock > current_clock()) {
+        self->wake_time = clock;
+        set_task_sleeping(self);
+    } else {
+        // Nothing to wait for: only give the CPU to tasks of same priority.
+        set_task_ready(self);
+    }
     schedule();
 }
 
@@ -464,10 +1021,22 @@ __attribute__((unused)) static void debug_print(void)
     struct task *p;
     printf("current: %d\n", current()->pid);
     printf("ready: [");
-    queue_for_each(p, &tasks_ready_queue, struct task, tasks)
+    queue_for_each(p, &edf_queue, struct task, tasks)
     {
         assert(p->state == TASK_READY);
-        printf("%d {prio %d}, ", p->pid, p->priority);
+        printf("%d {deadline %d}, ", p->pid, p->dl_abs_deadline);
+    }
+    for (int prio = MAX_PRIO; prio >= MIN_PRIO; prio--) {
+        queue_for_each(p, &ready_queues[prio], struct task, tasks)
+        {
+            assert(p->state == TASK_READY);
+            printf("%d {prio %d}, ", p->pid, p->priority);
+        }
+        queue_for_each(p, &fair_queues[prio], struct task, tasks)
+        {
+            assert(p->state == TASK_READY);
+            printf("%d {prio %d fair}, ", p->pid, p->priority);
+        }
     }
     printf("]\n");
     printf("dying: [");
@@ -477,11 +1046,18 @@ __attribute__((unused)) static void debug_print(void)
         printf("%d {prio %d}, ", p->pid, p->priority);
     }
     printf("]\n");
+    printf("orphans: [");
+    queue_for_each(p, &tasks_orphan_queue, struct task, tasks)
+    {
+        assert(p->state == TASK_ZOMBIE);
+        printf("%d, ", p->pid);
+    }
+    printf("]\n");
     printf("sleeping: [");
-    queue_for_each(p, &tasks_sleeping_queue, struct task, tasks)
+    queue_for_each(p, &global_task_list, struct task, global_tasks)
     {
-        assert(p->state == TASK_SLEEPING);
-        printf("%d {wake %d}, ", p->pid, p->wake_time);
+        if (is_task_sleeping(p))
+            printf("%d {wake %d}, ", p->pid, p->wake_time);
     }
     printf("]\n");
 }
\ No newline at end of file
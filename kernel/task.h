@@ -7,6 +7,10 @@
 #include "parameters.h"
 #include "types.h"
 #include "queue.h"
+#include "timer.h"
+#include "primitive.h"
+#include "paging.h"
+#include "sched_group.h"
 
 /* States */
 #define TASK_STARTUP 0x00
@@ -18,6 +22,7 @@
 #define TASK_INTERRUPTED_MSG 0x06
 #define TASK_INTERRUPTED_IO 0x07
 #define TASK_INTERRUPTED_CHILD 0x08
+#define TASK_THROTTLED 0x09
 
 typedef enum { EBX, ESP, EBP, ESI, EDI, CR3, ESP0, NB_REGS } saved_regs;
 
@@ -38,15 +43,48 @@ struct task {
     struct list_link children;
     struct list_link siblings;
     int              priority;
+    // Priority set by start() or chprio(). priority can be higher while the
+    // task is boosted by tasks blocked on one of its message queues.
+    int              base_priority;
+    // Ticks left before the task goes to the tail of its priority level
+    uint32_t         time_slice;
+    // SCHED_RR or SCHED_FAIR, see sched_setclass()
+    int              sched_class;
+    // For SCHED_FAIR: CPU share and weighted CPU time used
+    uint32_t         weight;
+    uint64_t         vruntime;
+    // For SCHED_DEADLINE: parameters, CPU bandwidth reserved by admission
+    // control, and start, absolute deadline and runtime left of the
+    // current job, in ticks
+    uint32_t         dl_runtime;
+    uint32_t         dl_deadline;
+    uint32_t         dl_period;
+    uint32_t         dl_bw;
+    uint32_t         dl_release;
+    uint32_t         dl_abs_deadline;
+    uint32_t         dl_runtime_left;
+    bool             dl_missed;
+    // Starts the next job of a throttled task
+    struct timer     dl_timer;
+    struct sched_dl_stats dl_stats;
+    // CPU bandwidth group, NULL if the task has no quota
+    struct sched_group   *group;
+    // CPU time used so far, see cputime.c. cputime_stamp is the cycle count
+    // of the last user/kernel transition, ready_stamp the one at which the
+    // task last became ready.
+    struct task_cputime   cputime;
+    uint64_t              cputime_stamp;
+    uint64_t              ready_stamp;
     uint32_t         wake_time;
+    // Wakes the task up at wake_time when it is sleeping
+    struct timer     sleep_timer;
     int              retval;
     // For queues
     int msg_val;
-    // Pages allocated for code and mem (to free)
-    uint32_t *code_pages;
-    int       nb_code_pages;
-    uint32_t *stack_pages;
-    int       nb_stack_pages;
+    // Address space, shared with the threads of the process, and slot of
+    // the stack of the task in it
+    struct user_space *space;
+    int                stack_slot;
     bool      first_start;
 };
 
@@ -61,16 +99,44 @@ int          is_current(struct task *task_ptr);
 int  is_task_running(struct task *task_ptr);
 void set_task_running(struct task *task_ptr);
 
-extern struct list_link tasks_ready_queue;
-int                     is_task_ready(struct task *task_ptr);
-void                    set_task_ready(struct task *task_ptr);
-void                    set_task_ready_or_running(struct task *task_ptr);
+int          is_task_ready(struct task *task_ptr);
+void         set_task_ready(struct task *task_ptr);
+void         set_task_ready_or_running(struct task *task_ptr);
+/**
+ * Get the oldest task of the highest priority level with ready tasks,
+ * without removing it from the ready queue.
+ * @return NULL if no task is ready
+ */
+struct task *ready_queue_top(void);
+
+/**
+ * Tells whether a should run before b: earliest deadline between
+ * SCHED_DEADLINE tasks, which run before all others, highest priority
+ * otherwise.
+ */
+bool task_outranks(struct task *a, struct task *b);
 
 int  is_task_sleeping(struct task *task_ptr);
 void set_task_sleeping(struct task *task_ptr);
 
+int  is_task_throttled(struct task *task_ptr);
+/**
+ * Take the task out of the ready queue until it is set ready again.
+ */
+void set_task_throttled(struct task *task_ptr);
+
 int  is_task_zombie(struct task *task_ptr);
 void set_task_zombie(struct task *task_ptr);
+/**
+ * Hand a zombie task that nobody will wait for to reap_zombies().
+ */
+void set_zombie_orphan(struct task *task_ptr);
+/**
+ * Free the zombie tasks handed to set_zombie_orphan(). Teardown frees the
+ * address space of each task, so it is kept off schedule(): the idle task
+ * reaps, and so does start() before allocating a new task.
+ */
+void reap_zombies(void);
 
 int  is_task_interrupted_child(struct task *task_ptr);
 void set_task_interrupted_child(struct task *task_ptr);
@@ -86,9 +152,32 @@ void alloc_user_stack(struct task *task_ptr, uint32_t stack_size);
 
 struct task *alloc_empty_task();
 void         free_task(struct task *task_ptr);
+/** Allocate a kernel stack of KSTACK_SZ bytes, freed by free_task. */
+void *alloc_kernel_stack(void);
 
 void set_task_name(struct task *task_ptr, const char *name);
 void set_task_priority(struct task *task_ptr, int priority);
+/**
+ * Give the task a full time slice, as configured for its priority band.
+ */
+void refill_time_slice(struct task *task_ptr);
+/**
+ * Get, and change, the time slices of the priority bands, see the
+ * sched_timeslice() syscall.
+ */
+int sched_timeslice(const char *spec, unsigned long *slices);
+/**
+ * Change the scheduling class and weight of a task, moving it to the
+ * right ready queue if needed.
+ */
+void set_task_sched_class(struct task *task_ptr, int sched_class,
+                          uint32_t weight);
+/**
+ * Make the task SCHED_DEADLINE, if admission control accepts its bandwidth.
+ * @return 0, or -EBUSY if the deadline tasks would not be schedulable.
+ */
+int set_task_deadline(struct task *task_ptr, uint32_t runtime,
+                      uint32_t deadline, uint32_t period);
 void set_task_pid(struct task *task_ptr, pid_t pid);
 void set_task_return_value(struct task *task_ptr, int retval);
 void set_parent_process(struct task *child, struct task *parent);
@@ -97,10 +186,19 @@ struct task *idle(void);
 int          is_idle(struct task *task_ptr);
 void         set_idle(struct task *task_ptr);
 
+/**
+ * Initialize the scheduler queues. Must be called before any task is created.
+ */
+void init_scheduler(void);
 void preempt_enable(void);
 void preempt_disable(void);
 bool is_preempt_enabled(void);
 void schedule(void);
+/**
+ * Account a clock tick to the running task. The task is preempted by tasks
+ * of the same priority only once its time slice is used up.
+ */
+void schedule_tick(void);
 void schedule_free_old_task(struct task *old_task);
 
 struct task *pid_to_task(pid_t pid);
@@ -0,0 +1,124 @@
+/**
+ * Kernel timers, stored in a hashed timer wheel.
+ *
+ * The wheel has WHEEL_SIZE slots, one per clock tick. A timer expiring at
+ * tick t is put in slot t % WHEEL_SIZE. Each slot is sorted by expiry, so
+ * timers of later turns of the wheel stay behind the ones that expire now:
+ *
+ *   wheel_time
+ *       │
+ *       ▼
+ *  ┌────┬────┬────┬────┬─────┬────┐
+ *  │ 0  │ 1  │ 2  │ 3  │ ... │255 │
+ *  └────┴────┴────┴────┴─────┴────┘
+ *          │
+ *          ▼
+ *        t=257 ─► t=513 ─► ...
+ *
+ * On each tick, run_timers() only looks at the slots of the ticks that
+ * elapsed, and stops at the first timer of a slot that is not expired.
+ * Processing a tick thus costs time proportional to the expired timers.
+ */
+
+#include "timer.h"
+#include "debug.h"
+
+#define WHEEL_SIZE 256
+#define WHEEL_SLOT(tick) (&wheel[(tick) % WHEEL_SIZE])
+
+static struct list_link wheel[WHEEL_SIZE];
+
+// Last tick processed by run_timers()
+static uint32_t wheel_time = 0;
+
+void init_timers(void)
+{
+    for (int i = 0; i < WHEEL_SIZE; i++) {
+        INIT_LIST_HEAD(&wheel[i]);
+    }
+}
+
+void timer_init(struct timer *timer, void (*callback)(void *data), void *data)
+{
+    timer->expiry   = 0;
+    timer->callback = callback;
+    timer->data     = data;
+    INIT_LINK(&timer->link);
+}
+
+void timer_add(struct timer *timer, uint32_t expiry)
+{
+    struct list_link *slot;
+    struct list_link *cur;
+
+    assert(!timer_pending(timer));
+
+    timer->expiry = expiry;
+    // A timer in the past must not wait for a full turn of the wheel:
+    // put it in the next slot to be processed.
+    slot = WHEEL_SLOT(expiry > wheel_time ? expiry : wheel_time + 1);
+
+    // Keep the slot sorted by expiry. Timers with the same expiry fire in the
+    // order they were added.
+    for (cur = slot->next; cur != slot; cur = cur->next) {
+        if (queue_entry(cur, struct timer, link)->expiry > expiry)
+            break;
+    }
+    timer->link.next = cur;
+    timer->link.prev = cur->prev;
+    cur->prev->next  = &timer->link;
+    cur->prev        = &timer->link;
+}
+
+uint32_t timer_ticks_to_next(uint32_t horizon)
+{
+    for (uint32_t i = 1; i <= horizon && i <= WHEEL_SIZE; i++) {
+        struct list_link *slot = WHEEL_SLOT(wheel_time + i);
+        // The first timer of a slot is the earliest of the slot.
+        if (!queue_empty(slot) &&
+            queue_entry(slot->next, struct timer, link)->expiry <=
+                wheel_time + i)
+            return i;
+    }
+    return horizon;
+}
+
+void timer_del(struct timer *timer)
+{
+    if (timer_pending(timer))
+        queue_del(timer, link);
+}
+
+bool timer_pending(struct timer *timer)
+{
+    return !IS_LINK_NULL(&timer->link);
+}
+
+static void run_slot(struct list_link *slot, uint32_t now)
+{
+    while (!queue_empty(slot)) {
+        struct timer *timer = queue_entry(slot->next, struct timer, link);
+        if (timer->expiry > now)
+            break;
+
+        queue_del(timer, link);
+        timer->callback(timer->data);
+    }
+}
+
+void run_timers(uint32_t now)
+{
+    uint32_t elapsed = now - wheel_time;
+
+    // After a full turn, every slot has been visited once.
+    if (elapsed > WHEEL_SIZE)
+        elapsed = WHEEL_SIZE;
+
+    // Advance wheel_time slot by slot, so that a callback adding an already
+    // expired timer puts it in a slot that is still to be processed.
+    while (elapsed--) {
+        wheel_time++;
+        run_slot(WHEEL_SLOT(wheel_time), now);
+    }
+    wheel_time = now;
+}
@@ -0,0 +1,62 @@
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "queue.h"
+
+/**
+ * A kernel timer: calls callback(data) once the clock reaches expiry.
+ * Timers are stored in a hashed timer wheel, see timer.c.
+ */
+struct timer {
+    // Clock tick (see current_clock()) at which the timer fires
+    uint32_t expiry;
+    void (*callback)(void *data);
+    void *data;
+    // Link in the wheel slot, null when the timer is not pending
+    struct list_link link;
+};
+
+/**
+ * Initialize the timer wheel. Must be called before any timer is added.
+ */
+void init_timers(void);
+
+/**
+ * Set the function called when the timer fires.
+ * The timer is not pending after this call.
+ */
+void timer_init(struct timer *timer, void (*callback)(void *data), void *data);
+
+/**
+ * Arm a timer. If expiry is already reached, the timer fires on the next
+ * call to run_timers().
+ * @pre the timer is not pending.
+ */
+void timer_add(struct timer *timer, uint32_t expiry);
+
+/**
+ * Disarm a timer. Does nothing if the timer is not pending.
+ */
+void timer_del(struct timer *timer);
+
+/**
+ * Whether the timer is armed and has not fired yet.
+ */
+bool timer_pending(struct timer *timer);
+
+/**
+ * Number of ticks until the next timer fires, counted from the last call to
+ * run_timers(). Only the next horizon ticks are looked at.
+ * @return horizon if no timer fires within horizon ticks.
+ */
+uint32_t timer_ticks_to_next(uint32_t horizon);
+
+/**
+ * Fire all timers whose expiry is lower or equal to now.
+ * Called by the clock interrupt handler on each tick.
+ */
+void run_timers(uint32_t now);
+
+#endif //__TIMER_H__
@@ -3,15 +3,24 @@
 #include "hash.h"
 #include "debug.h"
 #include "errno.h"
+#include "mem.h"
+#include "paging.h"
+#include "page_allocator.h"
 
 /**
  * Mapping from symbol to symbol table ptr.
  */
 hash_t symbol_to_uapp;
 
+/**
+ * Mapping from uapp ptr to its image, filled as apps are started.
+ */
+hash_t uapp_to_image;
+
 void uapp_init()
 {
     hash_init_string(&symbol_to_uapp);
+    hash_init_direct(&uapp_to_image);
     // The symbol table is automatically generated by
     // a script. We need to initialize the hash table ourselves however.
     struct uapps *current = (struct uapps *)symbols_table;
@@ -29,4 +38,57 @@ struct uapps *get_uapp_by_name(const char *name)
     }
 
     return uapp;
-}
\ No newline at end of file
+}
+
+/**
+ * Free an image and the first nb_pages pages of its copy.
+ */
+static void __free_uapp_image(struct uapp_image *image, int nb_pages)
+{
+    for (int i = 0; i < nb_pages; i++)
+        free_physical_page(image->pages[i], 1);
+    mem_free(image->pages, image->nb_pages * sizeof(uint32_t *));
+    mem_free(image, sizeof(struct uapp_image));
+}
+
+struct uapp_image *get_uapp_image(struct uapps *app)
+{
+    struct uapp_image *image = hash_get(&uapp_to_image, app, NULL);
+    if (image != NULL) {
+        return image;
+    }
+
+    image = mem_alloc(sizeof(struct uapp_image));
+    if (image == NULL)
+        return ERR_PTR(-ENOMEM);
+    image->size = app->end - app->start + 1;
+    // Round up, because we need a full page even if we store only some code.
+    image->nb_pages = (image->size / PAGE_SIZE) + 1;
+    image->pages    = mem_alloc(image->nb_pages * sizeof(uint32_t *));
+    if (image->pages == NULL) {
+        mem_free(image, sizeof(struct uapp_image));
+        return ERR_PTR(-ENOMEM);
+    }
+    for (int i = 0; i < image->nb_pages; i++) {
+        int offset = i * PAGE_SIZE;
+        int length = image->size - offset;
+
+        if (length > PAGE_SIZE)
+            length = PAGE_SIZE;
+        image->pages[i] = try_alloc_physical_page(1);
+        if (image->pages[i] == NULL) {
+            __free_uapp_image(image, i);
+            return ERR_PTR(-ENOMEM);
+        }
+        memcpy(image->pages[i], (uint8_t *)app->start + offset, length);
+        // Processes may read the end of the last page: do not leak old data.
+        memset((uint8_t *)image->pages[i] + length, 0, PAGE_SIZE - length);
+    }
+    image->template = NULL;
+
+    if (hash_set(&uapp_to_image, app, image) != 0) {
+        __free_uapp_image(image, image->nb_pages);
+        return ERR_PTR(-ENOMEM);
+    }
+    return image;
+}
@@ -8,6 +8,8 @@
 #ifndef _USERSPACE_APPS_H
 #define _USERSPACE_APPS_H
 
+#include "stdint.h"
+
 /**
  * Describes a userspace app. An app is provided as a chunk of data that
  * contains the code, and the data of the application.
@@ -22,6 +24,24 @@ struct uapps {
     void *end;
 };
 
+struct user_space;
+
+/**
+ * Copy of an app binary in kernel managed memory, shared by all the
+ * processes running the app: its pages are mapped copy-on-write.
+ * <pages>    the nb_pages physical pages of the binary, allocated one by
+ *            one: they need not be contiguous.
+ * <size>     the size of the binary.
+ * <template> address space ready to start the app, cloned by start(), or
+ *            NULL if the app is not registered as a template.
+ */
+struct uapp_image {
+    uint32_t **pages;
+    int nb_pages;
+    int size;
+    struct user_space *template;
+};
+
 /**
  * A table of descriptor that reference all userspace binaries.
  */
@@ -34,6 +54,13 @@ extern const struct uapps symbols_table[];
  */
 struct uapps * get_uapp_by_name(const char * name);
 
+/**
+ * Get the image of an app, copied from the binary on the first call.
+ * @param app
+ * @return the image, or ERR_PTR(-ENOMEM) if there is no memory for the copy
+ */
+struct uapp_image * get_uapp_image(struct uapps * app);
+
 /**
  * Init the hash table with all the symbols of the user processes
  */
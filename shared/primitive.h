@@ -2,12 +2,158 @@
 #define __PRIMITIVE_H__
 #include "stdint.h"
 
+/* Scheduling classes, see sched_setclass() */
+#define SCHED_RR 0
+#define SCHED_FAIR 1
+/* Weight of a fair class task, relative to other tasks of its priority */
+#define FAIR_DEFAULT_WEIGHT 1024
+#define FAIR_MAX_WEIGHT 65536
+/* Set with sched_setdeadline(), not with sched_setclass() */
+#define SCHED_DEADLINE 2
+
+/**
+ * Parameters and deadline statistics of a SCHED_DEADLINE task, in ticks.
+ */
+struct sched_dl_stats {
+    unsigned long runtime;
+    unsigned long deadline;
+    unsigned long period;
+    // Jobs started: one per period in which the task ran
+    unsigned long jobs;
+    // Jobs that were still running after their deadline
+    unsigned long misses;
+    // Jobs that used up their runtime and waited for the next period
+    unsigned long throttled;
+};
+
+/**
+ * CPU time used by a process, in processor cycles, and its context switches.
+ */
+struct task_cputime {
+    unsigned long long user;
+    unsigned long long kernel;
+    // Time spent ready, waiting for the CPU
+    unsigned long long wait;
+    // Switches because the process blocked, slept or yielded
+    unsigned long voluntary;
+    // Switches because the process was preempted
+    unsigned long involuntary;
+};
+
+/**
+ * A task state change, see sched_trace().
+ */
+struct sched_trace_event {
+    unsigned long long tsc;
+    int                pid;
+    int                prio;
+    // New state of the task: 0 starting, 1 running, 2 ready, 3 sleeping,
+    // 4 zombie, 5-8 blocked on a semaphore, a queue, an I/O or a child,
+    // 9 throttled
+    int                state;
+};
+
+/**
+ * Statistics of a cache of kernel objects, see slabinfo().
+ */
+struct slab_info {
+    char          name[16];
+    // Size of an object, in bytes
+    unsigned long size;
+    // Pages of the cache, the objects they hold, and the objects in use
+    unsigned long slabs;
+    unsigned long objects;
+    unsigned long active;
+    // Allocations and frees since boot
+    unsigned long allocs;
+    unsigned long frees;
+};
+
+/* Number of priority bands with their own time slice, see sched_timeslice() */
+#define SCHED_PRIO_BANDS 4
+
+/* Number of buckets of a latency histogram, see sched_latency() */
+#define SCHED_LATENCY_BUCKETS 32
+
 /**
- * Change the priority of the task for a given pid.
+ * Change the priority of the task for a given pid. A boost inherited from
+ * a message queue, see psetproto(), lasts until the end of the wait.
  * @return -1 if the pid or the priority is invalid, else the old prio of this
  * process
  */
 int chprio(int pid, int priority);
+/**
+ * Change the scheduling class of a process.
+ * Between priorities, scheduling stays strict. Within a priority,
+ * SCHED_RR tasks run in turn for a time slice, and run before SCHED_FAIR
+ * tasks. SCHED_FAIR tasks run in order of their virtual runtime, which
+ * grows slower for heavier tasks: each one gets a share of the CPU
+ * proportional to its weight.
+ * @param weight Weight of a SCHED_FAIR task, between 1 and FAIR_MAX_WEIGHT,
+ * ignored for SCHED_RR.
+ * @return 0, or a negative value if the pid, class or weight is invalid.
+ */
+int sched_setclass(int pid, int sched_class, int weight);
+/**
+ * Make a process SCHED_DEADLINE: every period ticks, it gets runtime ticks of
+ * CPU time before an absolute deadline, deadline ticks after the start of
+ * the period. Ready SCHED_DEADLINE tasks run before all other tasks, earliest
+ * deadline first. A task using up its runtime waits for its next period.
+ * Use sched_setclass() to go back to another class.
+ * @return 0, -EINVAL unless 0 < runtime <= deadline <= period, or -EBUSY if
+ * the SCHED_DEADLINE tasks would not all meet their deadlines.
+ */
+int sched_setdeadline(int pid, unsigned long runtime, unsigned long deadline,
+                      unsigned long period);
+/**
+ * Get the parameters and deadline statistics of a SCHED_DEADLINE process.
+ * @return 0, or a negative value if the pid or the pointer is invalid.
+ */
+int sched_getdlstats(int pid, struct sched_dl_stats *stats);
+/**
+ * Put a process in a new CPU bandwidth group: together, the process and the
+ * children it starts from now on may run quota ticks every period ticks,
+ * whatever their priority. Once the quota is used up, they wait for the next
+ * period.
+ * @param quota 0 to take the process out of its group, without limit.
+ * @return 0, or a negative value if the pid is invalid or unless
+ * 0 < quota <= period.
+ */
+int sched_setquota(int pid, unsigned long quota, unsigned long period);
+/**
+ * Get, and change, the time slices of the priority bands: the ticks a task
+ * runs before giving the CPU to another task of its priority. The
+ * SCHED_PRIO_BANDS bands split the priorities evenly, band 0 holding the
+ * lowest ones. A new slice applies from the next refill of each task.
+ * @param spec NULL, or the new slices in the format of the timeslice= boot
+ * argument: "<band 0>,<band 1>,...". Bands left out, or given 0, keep
+ * their slice.
+ * @param slices NULL, or an array of SCHED_PRIO_BANDS counters set to the
+ * slices before the change.
+ * @return 0, or a negative value if a pointer is invalid.
+ */
+int sched_timeslice(const char *spec, unsigned long *slices);
+/**
+ * Get the CPU time used by a process, and its number of context switches.
+ * @return 0, or a negative value if the pid or the pointer is invalid.
+ */
+int getcputime(int pid, struct task_cputime *cputime);
+/**
+ * Copy the latest task state changes recorded by the kernel, oldest first.
+ * @param count Size of events, the kernel keeps the last 256 changes.
+ * @return the number of events copied, or a negative value if the
+ * pointer is invalid.
+ */
+int sched_trace(struct sched_trace_event *events, int count);
+/**
+ * Get the histogram of the time tasks of a priority waited in the ready
+ * queue before running. buckets[i] counts the waits of 2^i to 2^(i+1) - 1
+ * cycles; the last bucket counts all longer waits.
+ * @param buckets Array of SCHED_LATENCY_BUCKETS counters.
+ * @return the number of waits, or a negative value if the priority or the
+ * pointer is invalid.
+ */
+int sched_latency(int prio, unsigned long *buckets);
 /**
  * Get the clock settings, setting quartz and ticks.
  */
@@ -35,7 +181,9 @@ void __attribute__((noreturn)) exit(int retval);
 int getpid(void);
 /**
  * Get the prio of a process.
- * @return ESRCH if the pid is invalid, else the prio
+ * @return ESRCH if the pid is invalid, else the prio, which is higher than
+ * the one given to chprio() while a message queue boosts the process, see
+ * psetproto().
  */
 int getprio(int pid);
 /**
@@ -55,8 +203,8 @@ int kill(int pid);
 int pcount(int id, int *count);
 /**
  * Create a new msg queue with capacity count.
- * @return a negative value if there are no queues available or count <= 0, else
- * the id of the created msg queue
+ * @return a negative value if there are no queues available, count <= 0 or
+ * there is no memory left, else the id of the created msg queue
  */
 int pcreate(int count);
 /**
@@ -113,10 +261,28 @@ int preset(int id);
  * If the process was waiting and pdelete/preset is called, then return a
  * negative value.
  *
- * @return -1 if id is invalid or process blocked and precieve/preset called,
- * else 0
+ * @return -1 if id is invalid, process blocked and precieve/preset called
+ * or there is no memory left for the msg, else 0
  */
 int psend(int id, int msg);
+/* Priority protocols of a message queue, see psetproto() */
+#define MSG_PROTO_NONE 0
+#define MSG_PROTO_INHERIT 1
+#define MSG_PROTO_CEILING 2
+/**
+ * Choose how a message queue avoids priority inversions.
+ *
+ * A process blocked on a full queue waits for the last process that
+ * received from it, one blocked on an empty queue waits for the last process
+ * that sent to it. With MSG_PROTO_INHERIT, that process runs with the
+ * priority of the highest priority process waiting for it; with
+ * MSG_PROTO_CEILING, it runs with the ceiling priority as long as someone
+ * waits for it. The boost ends with the wait. With MSG_PROTO_NONE, the
+ * default, priorities are never changed. preset() keeps the protocol.
+ * @param ceiling Priority used by MSG_PROTO_CEILING, ignored otherwise.
+ * @return 0, or a negative value if id, proto or ceiling is invalid.
+ */
+int psetproto(int id, int proto, int ceiling);
 /**
  * Creates a new process.
  * @param ssize Stack size guaranteed to the calling process.
@@ -129,6 +295,63 @@ int psend(int id, int msg);
  * incorrect or there is not enough space to allocte a process.
  */
 int start(const char *name, unsigned long ssize, int prio, void *arg);
+/**
+ * Register a user app as a template: the kernel prepares the address space
+ * of its processes once, and start() then only clones it, copy-on-write.
+ * Registering an app again has no effect.
+ * @param name Name of the user app.
+ * @return 0, or a negative value if there is no such app or no memory left
+ * for the template.
+ */
+int start_template(const char *name);
+/* Kinds of mappings, and error of mmap() */
+#define MAP_PRIVATE 1
+#define MAP_SHARED 2
+#define MAP_FAILED ((void *)-1)
+/**
+ * Map zeroed memory in the calling process, backed when first touched.
+ * A private mapping is copied by fork(), copy-on-write, and a shared one is
+ * the same memory in the child and its parent.
+ * @param length Size of the mapping, rounded up to a multiple of 4Ko.
+ * @param flags MAP_PRIVATE or MAP_SHARED.
+ * @return The address of the mapping, or MAP_FAILED.
+ */
+void *mmap(unsigned long length, int flags);
+/**
+ * Unmap the pages of [addr, addr + length) made by mmap, which may cover
+ * several mappings or part of one.
+ * @return 0, or a negative value if addr is not aligned on a page, the
+ * zone is out of the zone of mappings, or a hole in a mapping can't be made
+ * for lack of memory.
+ */
+int munmap(void *addr, unsigned long length);
+/**
+ * Copy the statistics of the caches of kernel objects, such as messages.
+ * @param count Size of info.
+ * @return the number of caches copied, or a negative value if the pointer
+ * is invalid.
+ */
+int slabinfo(struct slab_info *info, int count);
+/**
+ * Duplicate the calling process. The child runs the same code, with a copy
+ * of the memory of its parent, except shared memory pages. Pages are only
+ * copied when one of the processes writes to them.
+ * @return the pid of the child in the parent, 0 in the child, or a negative
+ * value if there is not enough space to allocate a process.
+ */
+int fork(void);
+/**
+ * Create a thread in the calling process. The thread runs func(arg) with a
+ * stack of its own, and shares the rest of the memory of the process. It
+ * exits with the return value of func, and can be waited for like a child
+ * process.
+ * @param ssize Stack size guaranteed to the thread.
+ * @param prio Priority of the thread.
+ * @return The pid of the thread, or a negative value if the arguments were
+ * incorrect or there is not enough space to allocate a thread.
+ */
+int thread_create(int (*func)(void *), unsigned long ssize, int prio,
+                  void *arg);
 /**
  * Set the process in sleeping state for a number of clock cycles.
  * @param clock The amount of clock cycles to wait.
@@ -172,7 +395,8 @@ void *shm_acquire(const char *key);
  */
 void shm_release(const char *key);
 /**
- * Syscall halt (du bled)
+ * Wait for the next interrupt. Used by the idle process, the clock may stop
+ * ticking while it waits.
  */
 void halt();
 
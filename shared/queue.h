@@ -191,6 +191,24 @@ static __inline__ void *__queue_out(link *head, unsigned long diff)
         	queue_add(ptr_elem, head, type, listfield, priofield); \
 		} while (0)
 
+// ***CUSTOMIZATION***
+/**
+ * Ajout d'un élément en fin de liste, sans tri (comportement FIFO).
+ * ptr_elem  : pointeur vers l'élément à chainer
+ * head      : pointeur vers la tête de liste
+ * listfield : nom du champ du lien de chainage
+ */
+#define queue_add_tail(ptr_elem, head, listfield)                            \
+	do {                                                                 \
+		link *__head = (head);                                       \
+		link *__elem_link = &((ptr_elem)->listfield);                \
+                assert((__elem_link->prev == 0) && (__elem_link->next == 0)); \
+		__elem_link->next = __head;                                  \
+		__elem_link->prev = __head->prev;                            \
+		__head->prev->next = __elem_link;                            \
+		__head->prev = __elem_link;                                  \
+	} while (0)
+
 // ***CUSTOMIZATION***
 /**
  * Parcours d'une file
@@ -23,3 +23,14 @@ void _start(void *arg)
     int retval = main(arg);
     exit(retval);
 }
+
+void _thread_start(int (*func)(void *), void *arg);
+
+/*
+ * Entry point of the threads made by thread_create: the kernel starts them
+ * here, with func and arg on their stack.
+ */
+void _thread_start(int (*func)(void *), void *arg)
+{
+    exit(func(arg));
+}
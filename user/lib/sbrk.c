@@ -11,23 +11,13 @@
 
 /*****************************************************************************
  * NOTE:
- * The sbrk implementation provided below works on a fixed-size heap. This is
- * provided as a stub to allow you to work without sbrk in a first time. But to
- * have a feature complete project, you'll have to implement it as a syscall.
- * See "man sbrk" for more details on specifications.
+ * The heap is managed by the kernel (syscall 45): it starts after the code of
+ * the process, and its pages are only allocated when first touched.
  *****************************************************************************/
 
 /* Import ptrdiff_t type */
 #include "types.h"
 
-/* 4 Ko heap */
-#define HEAP_SIZE       0x1000
-
-/* The program heap */
-static char heap[HEAP_SIZE];
-static char* const heap_end = (char *)heap + HEAP_SIZE;
-static char *current = (char *)heap;
-
 /**
  * Increment the program's data space by <increment> bytes. Calling sbrk()
  * with an increment of 0 can be used to find the current location of the
@@ -44,15 +34,7 @@ static char *current = (char *)heap;
  */
 void *sbrk(ptrdiff_t increment)
 {
-        char *s = current;
-	char *c = s + increment;
-
-	if ((c < current) || (c > heap_end)) {
-                /* We cannot grow the heap anymore */
-                return ((void*)(-1));
-        }
-        /* The heap grown */
-	current = c;
-	return s;
+        void *ret;
+        __asm__ volatile("int $49" : "=a"(ret) : "0"(45), "b"((int)increment));
+        return ret;
 }
-
@@ -127,4 +127,39 @@ DEF_SYSCALL1(29, void *, shm_acquire, const char *, key);
 DEF_SYSCALL1(30, void *, shm_release, const char *, key);
 DEF_SYSCALL0(31, void, halt);
 DEF_SYSCALL0(32, void, ps);
-DEF_SYSCALL1(33, void, change_color, unsigned char, color);
\ No newline at end of file
+DEF_SYSCALL1(33, void, change_color, unsigned char, color);
+DEF_SYSCALL3(34, int, sched_setclass, int, pid, int, sched_class, int, weight);
+struct sched_dl_stats;
+DEF_SYSCALL4(35, int, sched_setdeadline, int, pid, unsigned long, runtime,
+             unsigned long, deadline, unsigned long, period);
+DEF_SYSCALL2(36, int, sched_getdlstats, int, pid, struct sched_dl_stats *,
+             stats);
+DEF_SYSCALL3(37, int, sched_setquota, int, pid, unsigned long, quota,
+             unsigned long, period);
+struct task_cputime;
+DEF_SYSCALL2(38, int, getcputime, int, pid, struct task_cputime *, cputime);
+struct sched_trace_event;
+DEF_SYSCALL2(39, int, sched_trace, struct sched_trace_event *, events, int,
+             count);
+DEF_SYSCALL2(40, int, sched_latency, int, prio, unsigned long *, buckets);
+DEF_SYSCALL3(41, int, psetproto, int, fid, int, proto, int, ceiling);
+DEF_SYSCALL0(42, int, fork);
+DEF_SYSCALL1(44, int, start_template, const char *, name);
+DEF_SYSCALL2(46, void *, mmap, unsigned long, length, int, flags);
+DEF_SYSCALL2(47, int, munmap, void *, addr, unsigned long, length);
+struct slab_info;
+DEF_SYSCALL2(48, int, slabinfo, struct slab_info *, info, int, count);
+DEF_SYSCALL2(49, int, sched_timeslice, const char *, spec, unsigned long *,
+             slices);
+/* The kernel also needs the entry point of the thread, which calls exit with
+ * the return value of func (see crt0.c). We code this manually */
+extern void _thread_start(int (*func)(void *), void *arg);
+int thread_create(int (*func)(void *), unsigned long ssize, int prio, void *arg)
+{
+    int ret;
+    __asm__ volatile("int $49"
+                     : "=a"(ret)
+                     : "0"(43), "b"((int)func), "c"((int)ssize),
+                       "d"((int)prio), "S"((int)arg), "D"((int)_thread_start));
+    return ret;
+}
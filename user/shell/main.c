@@ -47,9 +47,18 @@ int main()
                    "autotest: Run all tests\n"
                    "help: Show all the command you can type\n"
                    "ps: display information about all process\n"
+                   "trace: display the last task state changes\n"
+                   "latency: display ready queue latencies by priority\n"
+                   "slabinfo: display the caches of kernel objects\n"
                    "exit: Exit the shell\n");
         } else if (strcmp(buff, "ps") == 0) {
             ps();
+        } else if (strcmp(buff, "trace") == 0) {
+            show_trace();
+        } else if (strcmp(buff, "latency") == 0) {
+            show_latency();
+        } else if (strcmp(buff, "slabinfo") == 0) {
+            show_slabinfo();
         } else if (strcmp(buff, "exit") == 0) {
             printf("Goodbye !\n");
             return 0;
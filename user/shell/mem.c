@@ -0,0 +1,18 @@
+#include <stdio.h>
+#include <primitive.h>
+#include "shell.h"
+
+#define SLAB_CACHES 16
+
+void show_slabinfo()
+{
+    struct slab_info info[SLAB_CACHES];
+    int count = slabinfo(info, SLAB_CACHES);
+
+    printf("%-12s size\tslabs\tobjects\tactive\tallocs\tfrees\n", "cache");
+    for (int i = 0; i < count; i++) {
+        printf("%-12s %lu\t%lu\t%lu\t%lu\t%lu\t%lu\n", info[i].name,
+               info[i].size, info[i].slabs, info[i].objects, info[i].active,
+               info[i].allocs, info[i].frees);
+    }
+}
@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <primitive.h>
+#include "shell.h"
+
+#define TRACE_EVENTS 32
+
+static const char *state_names[] = { "startup", "run",     "ready",
+                                     "sleep",   "zombie",  "in sem",
+                                     "in msg",  "in io",   "child",
+                                     "throttled" };
+
+void show_trace()
+{
+    struct sched_trace_event events[TRACE_EVENTS];
+    int count = sched_trace(events, TRACE_EVENTS);
+
+    printf("cycles\tpid\tprio\tstate\n");
+    for (int i = 0; i < count; i++) {
+        int state = events[i].state;
+        printf("+%lu\t%d\t%d\t",
+               (unsigned long)(events[i].tsc - events[0].tsc), events[i].pid,
+               events[i].prio);
+        if (state >= 0 &&
+            state < (int)(sizeof(state_names) / sizeof(state_names[0])))
+            printf("%s\n", state_names[state]);
+        else
+            printf("{%d}\n", state);
+    }
+}
+
+void show_latency()
+{
+    unsigned long buckets[SCHED_LATENCY_BUCKETS];
+
+    printf("prio\twaits\tcycles waited (2^i: count)\n");
+    for (int prio = 256; prio >= 1; prio--) {
+        int samples = sched_latency(prio, buckets);
+        if (samples <= 0)
+            continue;
+
+        printf("%d\t%d\t", prio, samples);
+        for (int i = 0; i < SCHED_LATENCY_BUCKETS; i++) {
+            if (buckets[i])
+                printf("2^%d: %lu  ", i, buckets[i]);
+        }
+        printf("\n");
+    }
+}
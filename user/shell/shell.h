@@ -2,5 +2,11 @@
 #define _SHELL_H_
 
 void display_title();
+// Last scheduler events, see sched_trace()
+void show_trace();
+// Ready queue latency histograms, see sched_latency()
+void show_latency();
+// Caches of kernel objects, see slabinfo()
+void show_slabinfo();
 
 #endif //_SHELL_H_
@@ -85,6 +85,10 @@ int pdelete(int fid);
 int preceive(int fid,int *message);
 int preset(int fid);
 int psend(int fid, int message);
+#define MSG_PROTO_NONE 0
+#define MSG_PROTO_INHERIT 1
+#define MSG_PROTO_CEILING 2
+int psetproto(int fid, int proto, int ceiling);
 #else
 # error "WITH_SEM" ou "WITH_MSG" doit être définie.
 #endif
@@ -105,6 +109,18 @@ unsigned long current_clock(void);
 void wait_clock(unsigned long wakeup);
 #endif
 int start(const char *process_name, unsigned long ssize, int prio, void *arg);
+int fork(void);
+int start_template(const char *name);
+void *sbrk(int increment);
+void *malloc(unsigned int size);
+void free(void *ptr);
+#define MAP_PRIVATE 1
+#define MAP_SHARED 2
+#define MAP_FAILED ((void *)-1)
+void *mmap(unsigned long length, int flags);
+int munmap(void *addr, unsigned long length);
+int thread_create(int (*func)(void *), unsigned long ssize, int prio,
+                  void *arg);
 int waitpid(int pid, int *retval);
 
 #if defined WITH_SEM
@@ -158,5 +174,50 @@ void shm_release(const char*);
 
 /* task */
 void ps(void);
+#define SCHED_RR 0
+#define SCHED_FAIR 1
+#define SCHED_DEADLINE 2
+int sched_setclass(int pid, int sched_class, int weight);
+struct sched_dl_stats {
+    unsigned long runtime;
+    unsigned long deadline;
+    unsigned long period;
+    unsigned long jobs;
+    unsigned long misses;
+    unsigned long throttled;
+};
+int sched_setdeadline(int pid, unsigned long runtime, unsigned long deadline,
+                      unsigned long period);
+int sched_getdlstats(int pid, struct sched_dl_stats *stats);
+int sched_setquota(int pid, unsigned long quota, unsigned long period);
+struct task_cputime {
+    unsigned long long user;
+    unsigned long long kernel;
+    unsigned long long wait;
+    unsigned long voluntary;
+    unsigned long involuntary;
+};
+int getcputime(int pid, struct task_cputime *cputime);
+struct sched_trace_event {
+    unsigned long long tsc;
+    int pid;
+    int prio;
+    int state;
+};
+#define SCHED_LATENCY_BUCKETS 32
+int sched_trace(struct sched_trace_event *events, int count);
+int sched_latency(int prio, unsigned long *buckets);
+struct slab_info {
+    char name[16];
+    unsigned long size;
+    unsigned long slabs;
+    unsigned long objects;
+    unsigned long active;
+    unsigned long allocs;
+    unsigned long frees;
+};
+int slabinfo(struct slab_info *info, int count);
+#define SCHED_PRIO_BANDS 4
+int sched_timeslice(const char *spec, unsigned long *slices);
 
 #endif /* _SYSAPI_H_ */
@@ -0,0 +1,57 @@
+/*******************************************************************************
+ * Test 23
+ *
+ * Cout de schedule() en fonction du nombre de processus prets. Le cout doit
+ * rester constant de 2 processus prets jusqu'a la limite du systeme.
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+#define MAX_READY 256
+#define SCHED_ROUNDS 1000
+
+static unsigned long sched_cost(void)
+{
+        unsigned long long tsc1;
+        unsigned long long tsc2;
+        int i;
+
+        __asm__ __volatile__("rdtsc":"=A"(tsc1));
+        for (i = 0; i < SCHED_ROUNDS; i++) {
+                /* Se rendormir jusqu'a l'instant 0 repasse par schedule() */
+                wait_clock(0);
+        }
+        __asm__ __volatile__("rdtsc":"=A"(tsc2));
+        return (unsigned long)div64(tsc2 - tsc1, SCHED_ROUNDS, 0);
+}
+
+int main(void *arg)
+{
+        int pids[MAX_READY];
+        int count = 0;
+        int target = 2;
+        int i;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        while (1) {
+                /* Processus de faible priorite : prets, mais jamais elus */
+                while (count < target) {
+                        int pid = start("no_run", 4000, 2, 0);
+                        if (pid < 0)
+                                break;
+                        pids[count++] = pid;
+                }
+                printf("%d ready: %lu cycles/schedule.\n", count, sched_cost());
+                if (count < target || target == MAX_READY)
+                        break;
+                target *= 2;
+        }
+
+        for (i = 0; i < count; i++) {
+                assert(kill(pids[i]) == 0);
+                assert(waitpid(pids[i], 0) == pids[i]);
+        }
+        return 0;
+}
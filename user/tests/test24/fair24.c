@@ -0,0 +1,14 @@
+#include "test24.h"
+
+int main(void *arg)
+{
+        volatile struct test24_shared *shared = NULL;
+        int i = (int)arg;
+
+        shared = (struct test24_shared*) shm_acquire("test24_shm");
+        assert(shared != NULL);
+        while (1) {
+                shared->count[i]++;
+        }
+        return 0;
+}
@@ -0,0 +1,58 @@
+/*******************************************************************************
+ * Test 24
+ *
+ * Classe d'ordonnancement equitable : deux processus de meme priorite, de
+ * poids 3 et 1, doivent se partager le processeur dans un rapport 3:1.
+ ******************************************************************************/
+
+#include "test24.h"
+
+int main(void *arg)
+{
+        volatile struct test24_shared *shared = NULL;
+        unsigned long quartz, ticks, dur, c0, c;
+        unsigned long heavy, light;
+        int pid1, pid2;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+        shared = (struct test24_shared*) shm_create("test24_shm");
+        assert(shared != NULL);
+        shared->count[0] = 0;
+        shared->count[1] = 0;
+
+        /* Arguments invalides */
+        assert(sched_setclass(getpid(), 42, 1024) < 0);
+        assert(sched_setclass(getpid(), SCHED_FAIR, 0) < 0);
+        assert(sched_setclass(-1, SCHED_FAIR, 1024) < 0);
+
+        /* Processus de priorite inferieure : ne tournent pas avant l'attente */
+        pid1 = start("fair24", 4000, 64, (void *)0);
+        pid2 = start("fair24", 4000, 64, (void *)1);
+        assert(pid1 > 0);
+        assert(pid2 > 0);
+        assert(sched_setclass(pid1, SCHED_FAIR, 3072) == 0);
+        assert(sched_setclass(pid2, SCHED_FAIR, 1024) == 0);
+
+        clock_settings(&quartz, &ticks);
+        dur = 2 * quartz / ticks;
+        c0 = current_clock();
+        do {
+                c = current_clock();
+        } while (c == c0);
+        wait_clock(c + dur);
+
+        heavy = shared->count[0];
+        light = shared->count[1];
+        assert(kill(pid1) == 0);
+        assert(waitpid(pid1, 0) == pid1);
+        assert(kill(pid2) == 0);
+        assert(waitpid(pid2, 0) == pid2);
+        shm_release("test24_shm");
+
+        printf("poids 3 : %lu, poids 1 : %lu\n", heavy, light);
+        assert(light > 0);
+        assert(heavy > 2 * light);
+        assert(heavy < 4 * light);
+        return 0;
+}
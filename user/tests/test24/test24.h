@@ -0,0 +1,10 @@
+#ifndef _TEST24_H_
+#define _TEST24_H_
+
+#include "sysapi.h"
+
+struct test24_shared {
+        unsigned long count[2];
+};
+
+#endif /* _TEST24_H_ */
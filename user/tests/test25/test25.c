@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * Test 25
+ *
+ * Classe d'ordonnancement EDF : controle d'admission, budget consomme a
+ * chaque periode, aucune echeance manquee pour un ensemble ordonnancable.
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+static void check_stats(int pid, unsigned long runtime, unsigned long periods)
+{
+        struct sched_dl_stats stats;
+
+        assert(sched_getdlstats(pid, &stats) == 0);
+        printf("%d : %lu travaux, %lu echeances manquees, %lu epuisements\n",
+               pid, stats.jobs, stats.misses, stats.throttled);
+        assert(stats.runtime == runtime);
+        assert(stats.misses == 0);
+        /* Processus toujours actif : le budget est epuise a chaque periode */
+        assert(stats.jobs + 2 >= periods);
+        assert(stats.throttled + 2 >= stats.jobs);
+}
+
+int main(void *arg)
+{
+        unsigned long c0, c;
+        struct sched_dl_stats stats;
+        int pid1, pid2, pid3;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        pid1 = start("edf25", 4000, 64, 0);
+        pid2 = start("edf25", 4000, 64, 0);
+        pid3 = start("edf25", 4000, 64, 0);
+        assert(pid1 > 0);
+        assert(pid2 > 0);
+        assert(pid3 > 0);
+
+        /* Parametres invalides */
+        assert(sched_setdeadline(pid1, 0, 5, 10) < 0);
+        assert(sched_setdeadline(pid1, 6, 5, 10) < 0);
+        assert(sched_setdeadline(pid1, 2, 11, 10) < 0);
+        assert(sched_getdlstats(pid1, &stats) < 0);
+
+        /* 2/5 + 3/10 du processeur : admis. 3/10 de plus : refuse */
+        assert(sched_setdeadline(pid1, 2, 5, 10) == 0);
+        assert(sched_setdeadline(pid2, 3, 10, 10) == 0);
+        assert(sched_setdeadline(pid3, 3, 10, 10) < 0);
+        assert(kill(pid3) == 0);
+        assert(waitpid(pid3, 0) == pid3);
+
+        /* 100 tops d'horloge : 10 periodes */
+        c0 = current_clock();
+        do {
+                c = current_clock();
+        } while (c == c0);
+        wait_clock(c + 100);
+
+        check_stats(pid1, 2, 10);
+        check_stats(pid2, 3, 10);
+
+        /* La bande passante est rendue a la fin du processus */
+        assert(kill(pid1) == 0);
+        assert(waitpid(pid1, 0) == pid1);
+        assert(kill(pid2) == 0);
+        assert(waitpid(pid2, 0) == pid2);
+        pid3 = start("edf25", 4000, 64, 0);
+        assert(pid3 > 0);
+        assert(sched_setdeadline(pid3, 9, 10, 10) == 0);
+        assert(sched_setclass(pid3, SCHED_RR, 0) == 0);
+        assert(kill(pid3) == 0);
+        assert(waitpid(pid3, 0) == pid3);
+        return 0;
+}
@@ -0,0 +1,14 @@
+$(eval $(call clear-module-vars))
+LOCAL_MODULE_PATH := $(call my-dir)
+
+$(eval $(call clear-process-vars))
+LOCAL_PROCESS_NAME := test25
+LOCAL_PROCESS_SRC := test25.c
+$(eval $(call build-test-process))
+
+$(eval $(call clear-process-vars))
+LOCAL_PROCESS_NAME := edf25
+LOCAL_PROCESS_SRC := edf25.c
+$(eval $(call build-test-process))
+
+$(eval $(call build-test-module))
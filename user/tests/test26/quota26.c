@@ -0,0 +1,20 @@
+#include "test26.h"
+
+int main(void *arg)
+{
+        volatile struct test26_shared *shared = NULL;
+        int i = (int)arg;
+
+        shared = (struct test26_shared*) shm_acquire("test26_shm");
+        assert(shared != NULL);
+        if (i == 0) {
+                /* Le fils partage le quota de son pere */
+                shared->helper = start("quota26", 4000, getprio(getpid()),
+                                       (void *)2);
+                assert(shared->helper > 0);
+        }
+        while (1) {
+                shared->count[i & 1]++;
+        }
+        return 0;
+}
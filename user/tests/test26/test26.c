@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * Test 26
+ *
+ * Groupes de bande passante : un processus de haute priorite et son fils,
+ * limites a 2 tops d'horloge toutes les 10, laissent le reste du processeur
+ * a un processus de basse priorite.
+ ******************************************************************************/
+
+#include "test26.h"
+
+int main(void *arg)
+{
+        volatile struct test26_shared *shared = NULL;
+        unsigned long c0, c;
+        unsigned long limited, other;
+        int pid1, pid2;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+        shared = (struct test26_shared*) shm_create("test26_shm");
+        assert(shared != NULL);
+        shared->count[0] = 0;
+        shared->count[1] = 0;
+        shared->helper = 0;
+
+        pid1 = start("quota26", 4000, 64, (void *)0);
+        pid2 = start("quota26", 4000, 64, (void *)1);
+        assert(pid1 > 0);
+        assert(pid2 > 0);
+
+        /* Parametres invalides */
+        assert(sched_setquota(pid1, 11, 10) < 0);
+        assert(sched_setquota(pid1, 1, 0) < 0);
+        assert(sched_setquota(-1, 2, 10) < 0);
+
+        assert(sched_setquota(pid1, 2, 10) == 0);
+        assert(chprio(pid1, 200) == 64);
+        assert(shared->helper > 0);
+
+        /* 100 tops d'horloge : 10 periodes */
+        c0 = current_clock();
+        do {
+                c = current_clock();
+        } while (c == c0);
+        wait_clock(c + 100);
+
+        limited = shared->count[0];
+        other = shared->count[1];
+        assert(kill(shared->helper) == 0);
+        assert(kill(pid1) == 0);
+        assert(waitpid(pid1, 0) == pid1);
+        assert(kill(pid2) == 0);
+        assert(waitpid(pid2, 0) == pid2);
+        shm_release("test26_shm");
+
+        printf("quota 2/10 : %lu, sans quota : %lu\n", limited, other);
+        assert(limited > 0);
+        assert(2 * limited < other);
+        assert(8 * limited > other);
+        return 0;
+}
@@ -0,0 +1,11 @@
+#ifndef _TEST26_H_
+#define _TEST26_H_
+
+#include "sysapi.h"
+
+struct test26_shared {
+        unsigned long count[2];
+        int helper;
+};
+
+#endif /* _TEST26_H_ */
@@ -0,0 +1,14 @@
+$(eval $(call clear-module-vars))
+LOCAL_MODULE_PATH := $(call my-dir)
+
+$(eval $(call clear-process-vars))
+LOCAL_PROCESS_NAME := test26
+LOCAL_PROCESS_SRC := test26.c
+$(eval $(call build-test-process))
+
+$(eval $(call clear-process-vars))
+LOCAL_PROCESS_NAME := quota26
+LOCAL_PROCESS_SRC := quota26.c
+$(eval $(call build-test-process))
+
+$(eval $(call build-test-module))
@@ -0,0 +1,53 @@
+/*******************************************************************************
+ * Test 27
+ *
+ * Centaines de processus vivants en meme temps : allocation des pids,
+ * recherche d'un processus par son pid, puis liberation et reutilisation.
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+#define NB_TASKS 500
+
+int main(void *arg)
+{
+        int pids[NB_TASKS];
+        int i, j, pid;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        /* Processus de faible priorite : prets, mais jamais elus */
+        for (i = 0; i < NB_TASKS; i++) {
+                pids[i] = start("no_run", 128, 2, 0);
+                assert(pids[i] > 0);
+                for (j = 0; j < i; j += 97)
+                        assert(pids[j] != pids[i]);
+        }
+        printf("%d processus, pids %d a %d.\n", NB_TASKS, pids[0],
+               pids[NB_TASKS - 1]);
+
+        for (i = 0; i < NB_TASKS; i++) {
+                assert(chprio(pids[i], 3) == 2);
+                assert(getprio(pids[i]) == 3);
+        }
+
+        /* Liberation dans le desordre */
+        for (i = 1; i < NB_TASKS; i += 2) {
+                assert(kill(pids[i]) == 0);
+                assert(waitpid(pids[i], 0) == pids[i]);
+                assert(getprio(pids[i]) < 0);
+        }
+        for (i = 0; i < NB_TASKS; i += 2) {
+                assert(kill(pids[i]) == 0);
+                assert(waitpid(pids[i], 0) == pids[i]);
+        }
+
+        /* Les pids liberes sont reutilises */
+        pid = start("no_run", 128, 2, 0);
+        assert(pid > 0);
+        assert(pid <= pids[NB_TASKS - 1]);
+        assert(kill(pid) == 0);
+        assert(waitpid(pid, 0) == pid);
+        return 0;
+}
@@ -0,0 +1,9 @@
+#include "sysapi.h"
+
+int main(void *arg)
+{
+        (void)arg;
+        while (1)
+                ;
+        return 0;
+}
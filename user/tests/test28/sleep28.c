@@ -0,0 +1,9 @@
+#include "sysapi.h"
+
+int main(void *arg)
+{
+        (void)arg;
+        while (1)
+                wait_clock(current_clock() + 2);
+        return 0;
+}
@@ -0,0 +1,52 @@
+/*******************************************************************************
+ * Test 28
+ *
+ * Comptabilisation du temps processeur : temps utilisateur d'un processus
+ * qui calcule, changements de contexte volontaires d'un processus qui dort.
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+int main(void *arg)
+{
+        struct task_cputime busy, sleeper;
+        unsigned long c0, c;
+        int pid1, pid2;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        pid1 = start("busy28", 4000, 64, 0);
+        pid2 = start("sleep28", 4000, 64, 0);
+        assert(pid1 > 0);
+        assert(pid2 > 0);
+
+        /* Arguments invalides */
+        assert(getcputime(-1, &busy) < 0);
+        assert(getcputime(pid1, (struct task_cputime *)0x1000) < 0);
+
+        /* 50 tops d'horloge */
+        c0 = current_clock();
+        do {
+                c = current_clock();
+        } while (c == c0);
+        wait_clock(c + 50);
+
+        assert(getcputime(pid1, &busy) == 0);
+        assert(getcputime(pid2, &sleeper) == 0);
+        assert(kill(pid1) == 0);
+        assert(waitpid(pid1, 0) == pid1);
+        assert(kill(pid2) == 0);
+        assert(waitpid(pid2, 0) == pid2);
+
+        printf("busy28 : user %lu, kernel %lu, wait %lu Mcycles, %lu/%lu\n",
+               (unsigned long)div64(busy.user, 1000000, 0),
+               (unsigned long)div64(busy.kernel, 1000000, 0),
+               (unsigned long)div64(busy.wait, 1000000, 0),
+               busy.voluntary, busy.involuntary);
+        printf("sleep28 : %lu changements volontaires\n", sleeper.voluntary);
+        assert(busy.user > busy.kernel);
+        assert(busy.involuntary > 0);
+        assert(sleeper.voluntary >= 10);
+        return 0;
+}
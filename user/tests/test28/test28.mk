@@ -0,0 +1,19 @@
+$(eval $(call clear-module-vars))
+LOCAL_MODULE_PATH := $(call my-dir)
+
+$(eval $(call clear-process-vars))
+LOCAL_PROCESS_NAME := test28
+LOCAL_PROCESS_SRC := test28.c
+$(eval $(call build-test-process))
+
+$(eval $(call clear-process-vars))
+LOCAL_PROCESS_NAME := busy28
+LOCAL_PROCESS_SRC := busy28.c
+$(eval $(call build-test-process))
+
+$(eval $(call clear-process-vars))
+LOCAL_PROCESS_NAME := sleep28
+LOCAL_PROCESS_SRC := sleep28.c
+$(eval $(call build-test-process))
+
+$(eval $(call build-test-module))
@@ -0,0 +1,58 @@
+/*******************************************************************************
+ * Test 29
+ *
+ * Traces de l'ordonnanceur : les changements d'etat d'un processus fils
+ * sont enregistres, et son attente dans la file des prets est comptee dans
+ * l'histogramme de sa priorite.
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+#define NB_EVENTS 64
+
+int main(void *arg)
+{
+        struct sched_trace_event events[NB_EVENTS];
+        unsigned long before[SCHED_LATENCY_BUCKETS];
+        unsigned long after[SCHED_LATENCY_BUCKETS];
+        int samples_before, samples_after;
+        int count, i, pid, seen_ready = 0, seen_zombie = 0;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        /* Arguments invalides */
+        assert(sched_latency(0, before) < 0);
+        assert(sched_latency(300, before) < 0);
+        assert(sched_trace(events, 0) < 0);
+        assert(sched_trace((struct sched_trace_event *)0x1000, 4) < 0);
+
+        samples_before = sched_latency(130, before);
+        assert(samples_before >= 0);
+
+        /* Le fils de plus haute priorite passe pret, s'execute et meurt */
+        pid = start("nothing", 4000, 130, 0);
+        assert(pid > 0);
+        assert(waitpid(pid, 0) == pid);
+
+        samples_after = sched_latency(130, after);
+        assert(samples_after > samples_before);
+
+        count = sched_trace(events, NB_EVENTS);
+        assert(count > 0 && count <= NB_EVENTS);
+        for (i = 0; i < count; i++) {
+                if (i > 0)
+                        assert(events[i].tsc >= events[i - 1].tsc);
+                if (events[i].pid != pid)
+                        continue;
+                if (events[i].state == 2)
+                        seen_ready = 1;
+                if (events[i].state == 4)
+                        seen_zombie = 1;
+        }
+        assert(seen_ready);
+        assert(seen_zombie);
+        printf("%d evenements, %d attentes a la priorite 130.\n", count,
+               samples_after);
+        return 0;
+}
@@ -0,0 +1,20 @@
+#include "sysapi.h"
+
+int main(void *arg)
+{
+        int fid = (int)arg;
+
+        /* Premier envoi : prod30 devient le producteur de la file */
+        assert(psend(fid, getprio(getpid())) == 0);
+
+        /* test30 attend : prod30 hérite de sa priorité, chprio ne change
+         * que la priorité de base */
+        assert(getprio(getpid()) == 128);
+        assert(chprio(getpid(), 20) == 10);
+        assert(getprio(getpid()) == 128);
+        assert(psend(fid, getprio(getpid())) == 0);
+
+        /* Plafond de priorité */
+        assert(psend(fid, getprio(getpid())) == 0);
+        return 0;
+}
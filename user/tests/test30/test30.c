@@ -0,0 +1,50 @@
+/*******************************************************************************
+ * Test 30
+ *
+ * Héritage et plafond de priorité sur une file de messages : un producteur
+ * de faible priorité attendu par test30 passe devant un processus de
+ * priorité moyenne qui calcule, puis retrouve sa priorité.
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+int main(void *arg)
+{
+        int fid, pid1, pid2, msg;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        fid = pcreate(1);
+        assert(fid >= 0);
+
+        /* Arguments invalides */
+        assert(psetproto(-1, MSG_PROTO_INHERIT, 0) < 0);
+        assert(psetproto(fid, 3, 0) < 0);
+        assert(psetproto(fid, MSG_PROTO_CEILING, 0) < 0);
+        assert(psetproto(fid, MSG_PROTO_CEILING, 257) < 0);
+        assert(psetproto(fid, MSG_PROTO_INHERIT, 0) == 0);
+
+        pid1 = start("prod30", 4000, 10, (void *)fid);
+        assert(pid1 > 0);
+        assert(preceive(fid, &msg) == 0);
+        assert(msg == 10);
+
+        /* Sans héritage, busy30 empêcherait prod30 de s'exécuter */
+        pid2 = start("busy30", 4000, 64, 0);
+        assert(pid2 > 0);
+        assert(preceive(fid, &msg) == 0);
+        assert(msg == 128);
+        assert(getprio(pid1) == 20);
+
+        assert(psetproto(fid, MSG_PROTO_CEILING, 200) == 0);
+        assert(preceive(fid, &msg) == 0);
+        assert(msg == 200);
+        assert(getprio(pid1) == 20);
+
+        assert(kill(pid2) == 0);
+        assert(waitpid(pid2, 0) == pid2);
+        assert(waitpid(pid1, 0) == pid1);
+        assert(pdelete(fid) == 0);
+        return 0;
+}
@@ -0,0 +1,24 @@
+$(eval $(call clear-module-vars))
+LOCAL_MODULE_PATH := $(call my-dir)
+
+# Build the test only if message queues are available.
+ifeq ("$(filter WITH_MSG,$(TESTS_OPTIONS))", "WITH_MSG")
+
+$(eval $(call clear-process-vars))
+LOCAL_PROCESS_NAME := test30
+LOCAL_PROCESS_SRC := test30.c
+$(eval $(call build-test-process))
+
+$(eval $(call clear-process-vars))
+LOCAL_PROCESS_NAME := prod30
+LOCAL_PROCESS_SRC := prod30.c
+$(eval $(call build-test-process))
+
+$(eval $(call clear-process-vars))
+LOCAL_PROCESS_NAME := busy30
+LOCAL_PROCESS_SRC := busy30.c
+$(eval $(call build-test-process))
+
+endif
+
+$(eval $(call build-test-module))
@@ -0,0 +1,23 @@
+#include "sysapi.h"
+
+/* Données de l'application, partagées en copie sur écriture */
+static int value = 31;
+static unsigned long quartz, ticks;
+
+int main(void *arg)
+{
+        int v = (int)arg;
+
+        /* Aucune instance précédente ne doit avoir modifié l'image */
+        assert(value == 31);
+        assert(quartz == 0);
+
+        /* Écriture par le noyau dans une page partagée */
+        clock_settings(&quartz, &ticks);
+        assert(quartz != 0);
+
+        value = v;
+        wait_clock(current_clock() + 2);
+        assert(value == v);
+        return value;
+}
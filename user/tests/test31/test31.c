@@ -0,0 +1,35 @@
+/*******************************************************************************
+ * Test 31
+ *
+ * Partage des pages d'une application entre ses instances : chaque
+ * instance écrit dans ses données sans modifier celles des autres.
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+#define NB_INSTANCES 10
+
+int main(void *arg)
+{
+        int pids[NB_INSTANCES];
+        int i, ret;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        for (i = 0; i < NB_INSTANCES; i++) {
+                pids[i] = start("cow31", 4000, 64, (void *)(i + 1));
+                assert(pids[i] > 0);
+        }
+        for (i = 0; i < NB_INSTANCES; i++) {
+                assert(waitpid(pids[i], &ret) == pids[i]);
+                assert(ret == i + 1);
+        }
+
+        /* Les écritures des instances terminées n'ont pas touché l'image */
+        pids[0] = start("cow31", 4000, 129, (void *)32);
+        assert(pids[0] > 0);
+        assert(waitpid(pids[0], &ret) == pids[0]);
+        assert(ret == 32);
+        return 0;
+}
@@ -0,0 +1,11 @@
+#include "sysapi.h"
+
+int main(void *arg)
+{
+        volatile char buf[8192];
+
+        (void)arg;
+        /* Sous la pile de 256 mots : page de garde */
+        buf[4096] = 1;
+        return buf[4096];
+}
@@ -0,0 +1,18 @@
+#include "sysapi.h"
+
+int main(void *arg)
+{
+        /* c est au fond de la pile, sur une page jamais touchée */
+        struct {
+                struct task_cputime c;
+                char pad[16000];
+        } frame;
+        int i;
+
+        /* Écriture par le noyau dans une page pas encore allouée */
+        assert(getcputime(getpid(), &frame.c) == 0);
+        for (i = 0; i < (int)sizeof(frame.pad); i++)
+                assert(frame.pad[i] == 0);
+        frame.pad[0] = 1;
+        return (int)arg;
+}
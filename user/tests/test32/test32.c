@@ -0,0 +1,29 @@
+/*******************************************************************************
+ * Test 32
+ *
+ * Pile allouée à la demande : les pages sont mises à zéro à leur premier
+ * accès, y compris par le noyau, et la page sous la pile est une page de
+ * garde.
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+int main(void *arg)
+{
+        int pid, ret;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        pid = start("stack32", 8000, 64, (void *)32);
+        assert(pid > 0);
+        assert(waitpid(pid, &ret) == pid);
+        assert(ret == 32);
+
+        /* Débordement de pile : le processus est tué */
+        pid = start("overflow32", 256, 64, 0);
+        assert(pid > 0);
+        assert(waitpid(pid, &ret) == pid);
+        assert(ret == 0);
+        return 0;
+}
@@ -0,0 +1,52 @@
+/*******************************************************************************
+ * Test 33
+ *
+ * fork : le fils reprend avec une copie des données et de la pile de son
+ * père, et leurs écritures ne se voient pas.
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+#define NB_CHILDREN 20
+
+static int value = 33;
+
+int main(void *arg)
+{
+        int pids[NB_CHILDREN];
+        int local = 1000;
+        int i, pid, ret;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        pid = fork();
+        assert(pid >= 0);
+        if (pid == 0) {
+                /* Fils : mêmes valeurs que le père au moment du fork */
+                assert(getprio(getpid()) == 128);
+                assert(value == 33 && local == 1000);
+                value = 1;
+                local = 2;
+                return value + local;
+        }
+        assert(waitpid(pid, &ret) == pid);
+        assert(ret == 3);
+        assert(value == 33 && local == 1000);
+
+        /* Chaque fils voit la valeur du père au moment de son fork */
+        for (i = 0; i < NB_CHILDREN; i++) {
+                pids[i] = fork();
+                assert(pids[i] >= 0);
+                if (pids[i] == 0) {
+                        chprio(getpid(), 64);
+                        return value + i;
+                }
+                value++;
+        }
+        for (i = 0; i < NB_CHILDREN; i++) {
+                assert(waitpid(pids[i], &ret) == pids[i]);
+                assert(ret == 33 + 2 * i);
+        }
+        return 0;
+}
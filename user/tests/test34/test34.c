@@ -0,0 +1,67 @@
+/*******************************************************************************
+ * Test 34
+ *
+ * thread_create : les threads partagent les données du processus, chacun
+ * avec sa propre pile, et se terminent avec la valeur de retour de leur
+ * fonction.
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+#define NB_THREADS 10
+
+static int shared = 0;
+
+static int worker(void *arg)
+{
+        int id = (int)arg;
+        int local[256];
+        int i;
+
+        /* Pile propre au thread, assez grande pour plusieurs pages */
+        for (i = 0; i < 256; i++)
+                local[i] = id;
+        shared += id;
+        for (i = 0; i < 256; i++)
+                assert(local[i] == id);
+        return id * 2;
+}
+
+static int child(void *arg)
+{
+        /* Plus prioritaire que le créateur : s'exécute tout de suite */
+        *(int *)arg = 34;
+        return 0;
+}
+
+int main(void *arg)
+{
+        int pids[NB_THREADS];
+        int seen = 0;
+        int i, pid, ret, sum = 0;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        pid = thread_create(child, 512, 129, &seen);
+        assert(pid > 0);
+        assert(seen == 34);
+        assert(waitpid(pid, &ret) == pid);
+        assert(ret == 0);
+
+        for (i = 0; i < NB_THREADS; i++) {
+                pids[i] = thread_create(worker, 1024, 128, (void *)(i + 1));
+                assert(pids[i] > 0);
+                sum += i + 1;
+        }
+        for (i = 0; i < NB_THREADS; i++) {
+                assert(waitpid(pids[i], &ret) == pids[i]);
+                assert(ret == 2 * (i + 1));
+        }
+        assert(shared == sum);
+
+        /* Arguments invalides */
+        assert(thread_create(worker, 1024, 0, 0) < 0);
+        assert(thread_create(worker, 1 << 20, 128, 0) < 0);
+        return 0;
+}
@@ -0,0 +1,41 @@
+/*******************************************************************************
+ * Test 35
+ *
+ * start_template : les processus d'une application enregistrée comme modèle
+ * démarrent d'une copie de son espace d'adressage, avec leur propre argument,
+ * leur pile et leurs données.
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+#define NB_PROCS 20
+
+int main(void *arg)
+{
+        int pids[NB_PROCS];
+        int i, ret;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        assert(start_template("no_such_app35") < 0);
+        assert(start_template("zygote35") == 0);
+        assert(start_template("zygote35") == 0);
+
+        for (i = 0; i < NB_PROCS; i++) {
+                pids[i] = start("zygote35", 4000, 64 + i, (void *)(i + 1));
+                assert(pids[i] > 0);
+                assert(getprio(pids[i]) == 64 + i);
+        }
+        for (i = 0; i < NB_PROCS; i++) {
+                assert(waitpid(pids[i], &ret) == pids[i]);
+                assert(ret == i + 1);
+        }
+
+        /* Plus prioritaire : s'exécute et se termine tout de suite */
+        pids[0] = start("zygote35", 4000, 129, (void *)35);
+        assert(pids[0] > 0);
+        assert(waitpid(pids[0], &ret) == pids[0]);
+        assert(ret == 35);
+        return 0;
+}
@@ -0,0 +1,19 @@
+#include "sysapi.h"
+
+static int counter = 0;
+
+int main(void *arg)
+{
+        /* Pile plus grande que celle du modèle */
+        char buf[12000];
+        int i;
+
+        for (i = 0; i < (int)sizeof(buf); i++)
+                assert(buf[i] == 0);
+        buf[0] = 1;
+
+        /* Données du processus : jamais modifiées par un autre */
+        assert(counter == 0);
+        counter += (int)arg;
+        return counter + buf[0] - 1;
+}
@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * Test 36
+ *
+ * sbrk : le tas grandit et rétrécit, ses pages sont mises à zéro à leur
+ * premier accès (y compris par le noyau), et malloc peut allouer plus que
+ * quelques pages.
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+#define PAGE 4096
+#define BIG (1024 * 1024)
+
+int main(void *arg)
+{
+        char *base, *big;
+        struct task_cputime *c;
+        int i, pid, ret;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        /* Croissance : pages à zéro */
+        base = sbrk(0);
+        assert(sbrk(4 * PAGE) == base);
+        assert(sbrk(0) == base + 4 * PAGE);
+        for (i = 0; i < 4 * PAGE; i++)
+                assert(base[i] == 0);
+        for (i = 0; i < 4 * PAGE; i++)
+                base[i] = 1;
+
+        /* Réduction : les pages libérées reviennent à zéro */
+        assert(sbrk(-3 * PAGE) == base + 4 * PAGE);
+        assert(sbrk(3 * PAGE) == base + PAGE);
+        assert(base[0] == 1);
+        for (i = PAGE; i < 4 * PAGE; i++)
+                assert(base[i] == 0);
+
+        /* Écriture du noyau dans une page du tas jamais touchée */
+        c = (struct task_cputime *)(base + 3 * PAGE);
+        assert(getcputime(getpid(), c) == 0);
+
+        /* Hors de la zone du tas */
+        assert(sbrk(0x7fffffff) == (void *)-1);
+        assert(sbrk(-0x10000000) == (void *)-1);
+        assert(sbrk(-4 * PAGE) == base + 4 * PAGE);
+        assert(sbrk(PAGE) == base);
+
+        /* Le fils a une copie du tas */
+        base[0] = 36;
+        pid = fork();
+        assert(pid >= 0);
+        if (pid == 0) {
+                assert(base[0] == 36);
+                base[0] = 0;
+                return 1;
+        }
+        assert(waitpid(pid, &ret) == pid);
+        assert(ret == 1 && base[0] == 36);
+
+        /* malloc au-delà de l'ancien tas fixe de 4 Ko */
+        big = malloc(BIG);
+        assert(big != NULL);
+        for (i = 0; i < BIG; i += PAGE)
+                big[i] = (char)i;
+        for (i = 0; i < BIG; i += PAGE)
+                assert(big[i] == (char)i);
+        free(big);
+        return 0;
+}
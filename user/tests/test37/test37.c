@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * Test 37
+ *
+ * mmap / munmap : mémoire anonyme allouée à la demande, privée (copiée au
+ * fork) ou partagée (la même pour le fils et son père).
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+#define PAGE 4096
+#define BIG (128 * 1024 * 1024)
+
+int main(void *arg)
+{
+        char *big, *priv, *shared, *p;
+        int i, pid, ret;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        assert(mmap(0, MAP_PRIVATE) == MAP_FAILED);
+        assert(mmap(PAGE, 3) == MAP_FAILED);
+
+        /* Grande zone : seules les pages touchées sont allouées */
+        big = mmap(BIG, MAP_PRIVATE);
+        assert(big != MAP_FAILED);
+        for (i = 0; i < BIG; i += 1024 * PAGE) {
+                assert(big[i] == 0);
+                big[i] = 37;
+        }
+        assert(munmap(big, BIG) == 0);
+
+        priv = mmap(4 * PAGE, MAP_PRIVATE);
+        shared = mmap(4 * PAGE, MAP_SHARED);
+        assert(priv != MAP_FAILED && shared != MAP_FAILED);
+        assert(priv != shared);
+        priv[0] = 1;
+        shared[0] = 1;
+
+        /* Écriture du fils : visible dans la zone partagée seulement */
+        pid = fork();
+        assert(pid >= 0);
+        if (pid == 0) {
+                assert(priv[0] == 1 && shared[0] == 1);
+                priv[0] = 2;
+                shared[0] = 2;
+                /* Page partagée touchée d'abord par le fils */
+                shared[3 * PAGE] = 3;
+                return 0;
+        }
+        assert(waitpid(pid, &ret) == pid);
+        assert(priv[0] == 1);
+        assert(shared[0] == 2 && shared[3 * PAGE] == 3);
+
+        /* Trou au milieu d'une zone : le reste reste accessible */
+        assert(munmap(shared + PAGE, PAGE) == 0);
+        assert(shared[0] == 2 && shared[3 * PAGE] == 3);
+        assert(munmap(priv + 1, PAGE) < 0);
+
+        /* Accès à une page libérée : le processus est tué */
+        pid = fork();
+        assert(pid >= 0);
+        if (pid == 0) {
+                p = shared + PAGE;
+                *p = 1;
+                return 1;
+        }
+        assert(waitpid(pid, &ret) == pid);
+        assert(ret == 0);
+
+        /* Une zone libérée puis réallouée est remise à zéro */
+        assert(munmap(priv, 4 * PAGE) == 0);
+        assert(munmap(shared, 4 * PAGE) == 0);
+        priv = mmap(4 * PAGE, MAP_PRIVATE);
+        assert(priv != MAP_FAILED);
+        for (i = 0; i < 4 * PAGE; i++)
+                assert(priv[i] == 0);
+        assert(munmap(priv, 4 * PAGE) == 0);
+        return 0;
+}
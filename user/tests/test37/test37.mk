@@ -0,0 +1,9 @@
+$(eval $(call clear-module-vars))
+LOCAL_MODULE_PATH := $(call my-dir)
+
+$(eval $(call clear-process-vars))
+LOCAL_PROCESS_NAME := test37
+LOCAL_PROCESS_SRC := test37.c
+$(eval $(call build-test-process))
+
+$(eval $(call build-test-module))
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * Test 38
+ *
+ * Caches d'objets du noyau : chaque message en file est pris dans le cache
+ * "msg" et lui est rendu quand il est reçu, ou quand la file est détruite.
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+#define NB_CACHES 16
+#define NB_MSG 600
+
+/* Statistiques du cache "msg", à zéro s'il n'a encore jamais servi */
+static void msg_stats(struct slab_info *stats)
+{
+        struct slab_info info[NB_CACHES];
+        int i, count;
+
+        count = slabinfo(info, NB_CACHES);
+        assert(count >= 0);
+        memset(stats, 0, sizeof(*stats));
+        for (i = 0; i < count; i++) {
+                assert(info[i].active <= info[i].objects);
+                assert(info[i].allocs - info[i].frees == info[i].active);
+                if (strcmp(info[i].name, "msg") == 0)
+                        *stats = info[i];
+        }
+}
+
+int main(void *arg)
+{
+        struct slab_info before, during, after;
+        int fid, i, msg;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+        assert(slabinfo(0, NB_CACHES) < 0);
+
+        msg_stats(&before);
+        fid = pcreate(NB_MSG);
+        assert(fid >= 0);
+        for (i = 0; i < NB_MSG; i++)
+                assert(psend(fid, i) == 0);
+
+        msg_stats(&during);
+        assert(during.active == before.active + NB_MSG);
+        assert(during.size > 0);
+        assert(during.slabs > 0 && during.objects >= during.active);
+
+        /* Chaque message reçu est rendu au cache */
+        for (i = 0; i < NB_MSG / 2; i++) {
+                assert(preceive(fid, &msg) == 0);
+                assert(msg == i);
+        }
+        msg_stats(&after);
+        assert(after.active == before.active + NB_MSG / 2);
+
+        /* Les messages restants sont rendus à la destruction de la file */
+        assert(pdelete(fid) == 0);
+        msg_stats(&after);
+        assert(after.active == before.active);
+        assert(after.frees == before.frees + NB_MSG);
+        assert(after.slabs <= during.slabs);
+        printf("ok.\n");
+        return 0;
+}
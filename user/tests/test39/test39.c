@@ -0,0 +1,78 @@
+/*******************************************************************************
+ * Test 39
+ *
+ * Grandes pages de 4 Mo : les grandes zones de mmap sont alignées sur 4 Mo,
+ * et la mémoire privée (mmap, tas) reste correcte quand une grande page est
+ * coupée en pages de 4 Ko (fork, munmap ou sbrk d'une partie).
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+#define PAGE 4096
+#define LARGE (4 * 1024 * 1024)
+
+int main(void *arg)
+{
+        char *small, *zone, *base, *heap;
+        struct task_cputime *c;
+        int i, pid, ret;
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        /* Une grande zone est alignée, même après une petite */
+        small = mmap(PAGE, MAP_PRIVATE);
+        zone = mmap(3 * LARGE, MAP_PRIVATE);
+        assert(small != MAP_FAILED && zone != MAP_FAILED);
+        assert((unsigned long)zone % LARGE == 0);
+
+        for (i = 0; i < 3 * LARGE; i += PAGE) {
+                assert(zone[i] == 0);
+                zone[i] = (char)(i / PAGE);
+        }
+
+        /* Écriture du noyau dans une grande page */
+        c = (struct task_cputime *)(zone + 2 * LARGE + 64);
+        assert(getcputime(getpid(), c) == 0);
+
+        /* Le fils a sa copie */
+        pid = fork();
+        assert(pid >= 0);
+        if (pid == 0) {
+                for (i = 0; i < 2 * LARGE; i += PAGE)
+                        assert(zone[i] == (char)(i / PAGE));
+                zone[0] = 39;
+                zone[LARGE] = 39;
+                return 1;
+        }
+        assert(waitpid(pid, &ret) == pid);
+        assert(ret == 1);
+        assert(zone[0] == 0 && zone[LARGE] == (char)(LARGE / PAGE));
+
+        /* Trou dans une grande page : le reste est intact */
+        assert(munmap(zone + 2 * LARGE + PAGE, PAGE) == 0);
+        assert(zone[2 * LARGE] == (char)(2 * LARGE / PAGE));
+        for (i = 2 * LARGE + 2 * PAGE; i < 3 * LARGE; i += PAGE)
+                assert(zone[i] == (char)(i / PAGE));
+        assert(munmap(zone, 3 * LARGE) == 0);
+        assert(munmap(small, PAGE) == 0);
+
+        /* Tas couvrant 4 Mo alignés */
+        base = sbrk(0);
+        heap = base + (LARGE - (unsigned long)base % LARGE) % LARGE;
+        assert(sbrk(heap - base + LARGE) == base);
+        for (i = 0; i < LARGE; i += PAGE) {
+                assert(heap[i] == 0);
+                heap[i] = 1;
+        }
+
+        /* Réduction au milieu : les pages libérées reviennent à zéro */
+        assert(sbrk(-(LARGE / 2)) == heap + LARGE);
+        assert(sbrk(LARGE / 2) == heap + LARGE / 2);
+        for (i = 0; i < LARGE / 2; i += PAGE)
+                assert(heap[i] == 1);
+        for (i = LARGE / 2; i < LARGE; i += PAGE)
+                assert(heap[i] == 0);
+        assert(sbrk(base - (char *)sbrk(0)) == heap + LARGE);
+        return 0;
+}
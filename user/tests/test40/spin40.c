@@ -0,0 +1,12 @@
+#include "sysapi.h"
+
+int main(void *arg)
+{
+        volatile unsigned long count = 0;
+
+        (void)arg;
+        while (1) {
+                count++;
+        }
+        return 0;
+}
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ * Test 40
+ *
+ * Tranches de temps par bande de priorite : l'argument timeslice= est lu
+ * par sched_timeslice(), et deux processus de meme priorite qui calculent
+ * ne se passent la main qu'a la fin de leur tranche.
+ ******************************************************************************/
+
+#include "sysapi.h"
+
+/* Priorite des processus qui calculent : dans la bande 0 */
+#define SPIN_PRIO 64
+
+static void check_slices(unsigned long b0, unsigned long b1, unsigned long b2,
+                         unsigned long b3)
+{
+        unsigned long slices[SCHED_PRIO_BANDS];
+
+        assert(sched_timeslice(NULL, slices) == 0);
+        assert(slices[0] == b0);
+        assert(slices[1] == b1);
+        assert(slices[2] == b2);
+        assert(slices[3] == b3);
+}
+
+/* Ecrit les tranches au format de timeslice= */
+static void format_slices(char *spec, const unsigned long *slices)
+{
+        unsigned long slice;
+        char digits[12];
+        int band, n;
+
+        for (band = 0; band < SCHED_PRIO_BANDS; band++) {
+                slice = slices[band];
+                n = 0;
+                do {
+                        digits[n++] = (char)('0' + slice % 10);
+                        slice /= 10;
+                } while (slice);
+                while (n > 0)
+                        *spec++ = digits[--n];
+                *spec++ = band < SCHED_PRIO_BANDS - 1 ? ',' : '\0';
+        }
+}
+
+/*
+ * Nombre de preemptions de deux processus de priorite SPIN_PRIO qui
+ * calculent pendant dur tops d'horloge.
+ */
+static unsigned long preemptions(const char *spec, unsigned long dur)
+{
+        struct task_cputime t1, t2;
+        unsigned long c0, c;
+        int pid1, pid2;
+
+        assert(sched_timeslice(spec, NULL) == 0);
+        pid1 = start("spin40", 4000, SPIN_PRIO, NULL);
+        pid2 = start("spin40", 4000, SPIN_PRIO, NULL);
+        assert(pid1 > 0);
+        assert(pid2 > 0);
+
+        c0 = current_clock();
+        do {
+                c = current_clock();
+        } while (c == c0);
+        wait_clock(c + dur);
+
+        assert(getcputime(pid1, &t1) == 0);
+        assert(getcputime(pid2, &t2) == 0);
+        assert(kill(pid1) == 0);
+        assert(waitpid(pid1, 0) == pid1);
+        assert(kill(pid2) == 0);
+        assert(waitpid(pid2, 0) == pid2);
+        return t1.involuntary + t2.involuntary;
+}
+
+int main(void *arg)
+{
+        unsigned long old[SCHED_PRIO_BANDS];
+        unsigned long quartz, ticks, dur;
+        unsigned long short_slices, long_slices;
+        char spec[64];
+
+        (void)arg;
+        assert(getprio(getpid()) == 128);
+
+        /* Tranches choisies au demarrage, rendues a la fin */
+        assert(sched_timeslice(NULL, old) == 0);
+        assert(old[0] > 0 && old[1] > 0 && old[2] > 0 && old[3] > 0);
+
+        /* Pointeurs invalides */
+        assert(sched_timeslice(NULL, (unsigned long *)0x1000) < 0);
+        assert(sched_timeslice((const char *)0x1000, NULL) < 0);
+
+        /* Format de timeslice= : une bande omise ou a 0 garde sa tranche */
+        assert(sched_timeslice("1,2,3,4", NULL) == 0);
+        check_slices(1, 2, 3, 4);
+        assert(sched_timeslice("5", NULL) == 0);
+        check_slices(5, 2, 3, 4);
+        assert(sched_timeslice("0,7", NULL) == 0);
+        check_slices(5, 7, 3, 4);
+        assert(sched_timeslice("x", NULL) == 0);
+        check_slices(5, 7, 3, 4);
+
+        /* Un top par tranche, puis quatre */
+        clock_settings(&quartz, &ticks);
+        dur = 2 * quartz / ticks;
+        short_slices = preemptions("1", dur);
+        long_slices = preemptions("4", dur);
+
+        format_slices(spec, old);
+        assert(sched_timeslice(spec, NULL) == 0);
+
+        printf("preemptions en %lu tops : %lu (tranche 1), %lu (tranche 4)\n",
+               dur, short_slices, long_slices);
+        assert(short_slices >= dur / 2);
+        assert(short_slices <= dur + 2);
+        assert(long_slices >= dur / 8);
+        assert(long_slices <= dur / 4 + 2);
+        return 0;
+}
@@ -0,0 +1,14 @@
+$(eval $(call clear-module-vars))
+LOCAL_MODULE_PATH := $(call my-dir)
+
+$(eval $(call clear-process-vars))
+LOCAL_PROCESS_NAME := test40
+LOCAL_PROCESS_SRC := test40.c
+$(eval $(call build-test-process))
+
+$(eval $(call clear-process-vars))
+LOCAL_PROCESS_NAME := spin40
+LOCAL_PROCESS_SRC := spin40.c
+$(eval $(call build-test-process))
+
+$(eval $(call build-test-module))